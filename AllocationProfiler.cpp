@@ -0,0 +1,386 @@
+/*!*************************************************************************************************
+\file    AllocationProfiler.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the AllocationProfiler.
+***************************************************************************************************/
+
+#include "AllocationProfiler.h"  // AllocationProfiler
+#include <algorithm>             // std::upper_bound
+#include <cstdio>                // snprintf
+#include <functional>            // std::less
+#include <new>                   // std::bad_alloc
+#include <ostream>               // std::ostream
+#include <utility>               // std::make_pair
+
+// Each thread rolls its own dice, so deciding to sample never touches shared memory
+static thread_local std::uint64_t SampleState = 0;
+
+// Sampled allocations are counted in buckets of BucketMilliseconds for the rate over time
+AllocationProfiler::AllocationProfiler(unsigned SampleRate, unsigned BucketMilliseconds)
+                                       : SampleRate_(SampleRate == 0 ? 1 : SampleRate),
+                                         BucketNanoseconds_((BucketMilliseconds == 0 ? 1 : BucketMilliseconds) * 1000000ull),
+                                         Start_(get_clock())
+{
+  for (unsigned i = 0; i < FILTER_SIZE; ++i)
+    Filter_[i].store(0, std::memory_order_relaxed);
+}
+
+// Returns true if the next allocation on this thread should be recorded, only touches thread local state
+bool AllocationProfiler::ShouldSample(void) const
+{
+  // Seed from the thread's own address the first time
+  if (SampleState == 0)
+    SampleState = reinterpret_cast<std::uintptr_t>(&SampleState) | 1;
+
+  // xorshift64, random enough that a pattern in the allocations can't line up with the samples
+  SampleState ^= SampleState << 13;
+  SampleState ^= SampleState >> 7;
+  SampleState ^= SampleState << 17;
+
+  return SampleState % SampleRate_ == 0;
+}
+
+// Records a sampled allocation, sites are told apart by Label or, without one, by CallSite
+void AllocationProfiler::RecordAllocate(const void *Object, size_t Size, const char *Label, const void *CallSite)
+{
+  std::uint64_t now = get_time();
+
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  // The profiler is best effort, running out of memory just drops the sample
+  try
+  {
+    // A label's buffer can be freed and reused for another label, so go by its text, not its address
+    size_t index = Sites_.size();
+    if (Label != nullptr)
+      index = LabelIndex_.insert(std::make_pair(std::string(Label), index)).first->second;
+    else
+      index = CallSiteIndex_.insert(std::make_pair(CallSite, index)).first->second;
+
+    // First time this site has been sampled
+    if (index == Sites_.size())
+    {
+      Site site = Site();
+      if (Label != nullptr)
+        site.Name = Label;
+      else
+      {
+        char name[32];
+        snprintf(name, sizeof(name), "%p", CallSite);
+        site.Name = name;
+      }
+      site.LifetimeMin = ~std::uint64_t(0);
+
+      try
+      {
+        Sites_.push_back(site);
+      }
+      catch (std::bad_alloc&)
+      {
+        // Don't leave an index pointing past the end
+        if (Label != nullptr)
+          LabelIndex_.erase(site.Name);
+        else
+          CallSiteIndex_.erase(CallSite);
+        throw;
+      }
+    }
+
+    Site& site = Sites_[index];
+    ++site.Samples;
+    site.Bytes += Size;
+
+    add_to_series(AllocationSeries_, static_cast<size_t>(now / BucketNanoseconds_));
+
+    // Remember it so its free can be timed, the filter lets frees of other objects skip the lock
+    LiveSample sample = { index, now };
+    if (Live_.insert(std::make_pair(Object, sample)).second)
+      Filter_[get_filter_slot(Object)].fetch_add(1, std::memory_order_relaxed);
+  }
+  catch (std::bad_alloc&)
+  {
+  }
+}
+
+// Records a free, only sampled objects cost more than a counter lookup
+void AllocationProfiler::RecordFree(const void *Object)
+{
+  // Nothing sampled hashes here
+  std::atomic<std::uint16_t>& filter = Filter_[get_filter_slot(Object)];
+  if (filter.load(std::memory_order_relaxed) == 0)
+    return;
+
+  std::uint64_t now = get_time();
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  // Something else that hashes to the same slot
+  std::unordered_map<const void*, LiveSample>::iterator found = Live_.find(Object);
+  if (found == Live_.end())
+    return;
+
+  record_lifetime(Sites_[found->second.Site], now - found->second.Time);
+
+  Live_.erase(found);
+  filter.fetch_sub(1, std::memory_order_relaxed);
+
+  try
+  {
+    add_to_series(FreeSeries_, static_cast<size_t>(now / BucketNanoseconds_));
+  }
+  catch (std::bad_alloc&)
+  {
+  }
+}
+
+// Records a free of every sampled object on the pages at once, for allocators that take objects back in bulk
+// Pages holds Count page starts in ascending order, each PageSize bytes long
+void AllocationProfiler::RecordFreeAll(const char *const *Pages, size_t Count, size_t PageSize)
+{
+  if (Count == 0)
+    return;
+
+  std::uint64_t now = get_time();
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  // One pass over the samples, each one looks for its page
+  std::uint64_t freed = 0;
+  std::unordered_map<const void*, LiveSample>::iterator it = Live_.begin();
+  while (it != Live_.end())
+  {
+    const char* address = static_cast<const char*>(it->first);
+    const char* const* next = std::upper_bound(Pages, Pages + Count, address, std::less<const char*>());
+    if (next == Pages || address >= *(next - 1) + PageSize)
+    {
+      ++it;
+      continue;
+    }
+
+    record_lifetime(Sites_[it->second.Site], now - it->second.Time);
+    Filter_[get_filter_slot(it->first)].fetch_sub(1, std::memory_order_relaxed);
+    it = Live_.erase(it);
+    ++freed;
+  }
+
+  try
+  {
+    size_t bucket = static_cast<size_t>(now / BucketNanoseconds_);
+    for (std::uint64_t i = 0; i < freed; ++i)
+      add_to_series(FreeSeries_, bucket);
+  }
+  catch (std::bad_alloc&)
+  {
+  }
+}
+
+// Writes every site, the lifetime histograms and the rate over time as one JSON object
+void AllocationProfiler::WriteJSON(std::ostream &out) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  out << "{\n  \"sample_rate\": " << SampleRate_ << ",\n";
+  out << "  \"bucket_ms\": " << BucketNanoseconds_ / 1000000 << ",\n";
+  out << "  \"sites\": [";
+
+  for (size_t i = 0; i < Sites_.size(); ++i)
+  {
+    const Site& site = Sites_[i];
+
+    out << (i == 0 ? "\n" : ",\n") << "    {\"site\": ";
+    write_json_string(out, site.Name);
+    out << ", \"samples\": " << site.Samples
+        << ", \"estimated_allocations\": " << site.Samples * SampleRate_
+        << ", \"live_samples\": " << site.Samples - site.Frees
+        << ", \"bytes\": " << site.Bytes
+        << ", \"lifetime_ns\": {\"count\": " << site.Frees
+        << ", \"mean\": " << (site.Frees != 0 ? site.LifetimeTotal / site.Frees : 0)
+        << ", \"min\": " << (site.Frees != 0 ? site.LifetimeMin : 0)
+        << ", \"max\": " << site.LifetimeMax
+        << ", \"log2_histogram\": [";
+
+    // Leave off the empty buckets at the end
+    unsigned used = LIFETIME_BUCKETS;
+    while (used > 0 && site.Lifetimes[used - 1] == 0)
+      --used;
+    for (unsigned b = 0; b < used; ++b)
+      out << (b == 0 ? "" : ", ") << site.Lifetimes[b];
+
+    out << "]}}";
+  }
+
+  out << "\n  ],\n  \"estimated_allocations_per_bucket\": [";
+  for (size_t i = 0; i < AllocationSeries_.size(); ++i)
+    out << (i == 0 ? "" : ", ") << AllocationSeries_[i] * SampleRate_;
+
+  out << "],\n  \"estimated_frees_per_bucket\": [";
+  for (size_t i = 0; i < FreeSeries_.size(); ++i)
+    out << (i == 0 ? "" : ", ") << FreeSeries_[i] * SampleRate_;
+
+  out << "]\n}\n";
+}
+
+// Writes one row per site
+void AllocationProfiler::WriteCSV(std::ostream &out) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  out << "site,samples,estimated_allocations,live_samples,bytes,mean_lifetime_ns,min_lifetime_ns,max_lifetime_ns\n";
+
+  for (size_t i = 0; i < Sites_.size(); ++i)
+  {
+    const Site& site = Sites_[i];
+
+    // Labels can have commas in them, so quote every name and double its quotes
+    out << '"';
+    for (size_t c = 0; c < site.Name.size(); ++c)
+      out << (site.Name[c] == '"' ? "\"\"" : std::string(1, site.Name[c]));
+    out << '"';
+
+    out << ',' << site.Samples
+        << ',' << site.Samples * SampleRate_
+        << ',' << site.Samples - site.Frees
+        << ',' << site.Bytes
+        << ',' << (site.Frees != 0 ? site.LifetimeTotal / site.Frees : 0)
+        << ',' << (site.Frees != 0 ? site.LifetimeMin : 0)
+        << ',' << site.LifetimeMax << '\n';
+  }
+}
+
+// Writes one row per time bucket with the estimated allocations and frees
+void AllocationProfiler::WriteRateCSV(std::ostream &out) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  out << "bucket_start_ms,estimated_allocations,estimated_frees\n";
+
+  size_t buckets = AllocationSeries_.size() > FreeSeries_.size() ? AllocationSeries_.size() : FreeSeries_.size();
+  for (size_t i = 0; i < buckets; ++i)
+  {
+    out << i * (BucketNanoseconds_ / 1000000)
+        << ',' << (i < AllocationSeries_.size() ? AllocationSeries_[i] : 0) * SampleRate_
+        << ',' << (i < FreeSeries_.size() ? FreeSeries_[i] : 0) * SampleRate_ << '\n';
+  }
+}
+
+// Forgets everything recorded so far
+void AllocationProfiler::Reset(void)
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  Sites_.clear();
+  LabelIndex_.clear();
+  CallSiteIndex_.clear();
+  Live_.clear();
+  AllocationSeries_.clear();
+  FreeSeries_.clear();
+
+  // get_time reads it without the lock
+  Start_.store(get_clock(), std::memory_order_relaxed);
+
+  for (unsigned i = 0; i < FILTER_SIZE; ++i)
+    Filter_[i].store(0, std::memory_order_relaxed);
+}
+
+/***************************************************************************************************
+  Testing/Debugging/Statistic methods
+***************************************************************************************************/
+
+// returns one in how many allocations are sampled
+unsigned AllocationProfiler::GetSampleRate(void) const
+{
+  return SampleRate_;
+}
+
+// returns how many different sites have been seen
+size_t AllocationProfiler::GetSiteCount(void) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  return Sites_.size();
+}
+
+// returns how many sampled objects haven't been freed
+size_t AllocationProfiler::GetLiveSamples(void) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  return Live_.size();
+}
+
+/***************************************************************************************************
+  Private methods
+***************************************************************************************************/
+
+// nanoseconds since Start_
+std::uint64_t AllocationProfiler::get_time(void) const
+{
+  // A Reset on another thread can move Start_ past a time read just before it
+  std::int64_t elapsed = get_clock() - Start_.load(std::memory_order_relaxed);
+
+  return elapsed > 0 ? static_cast<std::uint64_t>(elapsed) : 0;
+}
+
+// nanoseconds on Clock
+std::int64_t AllocationProfiler::get_clock(void)
+{
+  return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+// hashes an address into Filter_
+size_t AllocationProfiler::get_filter_slot(const void *Object)
+{
+  // Fibonacci hashing, the low bits of an address are mostly alignment
+  std::uint64_t hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(Object)) * 0x9E3779B97F4A7C15ull;
+
+  return static_cast<size_t>(hash >> 52) % FILTER_SIZE;
+}
+
+// counts a sampled object's free at its site
+void AllocationProfiler::record_lifetime(Site &Sampled, std::uint64_t Lifetime)
+{
+  // How long it lived
+  ++Sampled.Frees;
+  Sampled.LifetimeTotal += Lifetime;
+  if (Lifetime < Sampled.LifetimeMin)
+    Sampled.LifetimeMin = Lifetime;
+  if (Lifetime > Sampled.LifetimeMax)
+    Sampled.LifetimeMax = Lifetime;
+
+  unsigned bucket = 0;
+  while (bucket + 1 < LIFETIME_BUCKETS && (Lifetime >> (bucket + 1)) != 0)
+    ++bucket;
+  ++Sampled.Lifetimes[bucket];
+}
+
+// counts one event in a bucket
+void AllocationProfiler::add_to_series(std::vector<std::uint64_t> &Series, size_t Bucket)
+{
+  if (Bucket >= Series.size())
+    Series.resize(Bucket + 1, 0);
+
+  ++Series[Bucket];
+}
+
+// quotes and escapes a string
+void AllocationProfiler::write_json_string(std::ostream &out, const std::string &Text)
+{
+  out << '"';
+
+  for (size_t i = 0; i < Text.size(); ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(Text[i]);
+
+    if (c == '"' || c == '\\')
+      out << '\\' << Text[i];
+    else if (c < 0x20)
+    {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out << escaped;
+    }
+    else
+      out << Text[i];
+  }
+
+  out << '"';
+}
@@ -0,0 +1,115 @@
+/*!*************************************************************************************************
+\file    AllocationProfiler.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds a sampling profiler that records which labels or call sites allocate out of
+         an ObjectAllocator, how long those objects live and how fast they are allocated.
+         ObjectAllocator only calls into it when built with OA_PROFILING defined.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef ALLOCATIONPROFILERH
+#define ALLOCATIONPROFILERH
+//--------------------------------------------------------------------------------------------------
+
+#include <atomic>         // std::atomic
+#include <chrono>         // std::chrono::steady_clock
+#include <cstdint>        // std::uint16_t, std::uint64_t, std::int64_t
+#include <iosfwd>         // std::ostream
+#include <mutex>          // std::mutex
+#include <string>         // std::string
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+// Samples about one in SampleRate allocations, one profiler can be shared by many allocators
+class AllocationProfiler
+{
+  public:
+
+    static const unsigned LIFETIME_BUCKETS = 48;  // powers of two of nanoseconds
+    static const unsigned FILTER_SIZE = 4096;     // counters that let most frees skip the lock
+
+    // Sampled allocations are counted in buckets of BucketMilliseconds for the rate over time
+    explicit AllocationProfiler(unsigned SampleRate = 100, unsigned BucketMilliseconds = 1000);
+
+    // Returns true if the next allocation on this thread should be recorded, only touches thread local state
+    bool ShouldSample(void) const;
+
+    // Records a sampled allocation, sites are told apart by Label or, without one, by CallSite
+    // Labels are compared by their text, so the same label from different buffers is one site
+    void RecordAllocate(const void *Object, size_t Size, const char *Label, const void *CallSite);
+
+    // Records a free, only sampled objects cost more than a counter lookup
+    void RecordFree(const void *Object);
+
+    // Records a free of every sampled object on the pages at once, for allocators that take objects back in bulk
+    // Pages holds Count page starts in ascending order, each PageSize bytes long
+    void RecordFreeAll(const char *const *Pages, size_t Count, size_t PageSize);
+
+    // Writes every site, the lifetime histograms and the rate over time as one JSON object
+    void WriteJSON(std::ostream &out) const;
+
+    // Writes one row per site
+    void WriteCSV(std::ostream &out) const;
+
+    // Writes one row per time bucket with the estimated allocations and frees
+    void WriteRateCSV(std::ostream &out) const;
+
+    // Forgets everything recorded so far
+    void Reset(void);
+
+    // Testing/Debugging/Statistic methods
+    unsigned GetSampleRate(void) const;   // returns one in how many allocations are sampled
+    size_t GetSiteCount(void) const;      // returns how many different sites have been seen
+    size_t GetLiveSamples(void) const;    // returns how many sampled objects haven't been freed
+
+  private:
+
+    // Everything sampled from one label or call site
+    struct Site
+    {
+      std::string Name;                                 // the label, or the call site's address
+      std::uint64_t Samples;                            // sampled allocations
+      std::uint64_t Frees;                              // sampled allocations that were freed
+      std::uint64_t Bytes;                              // bytes in the sampled allocations
+      std::uint64_t LifetimeTotal;                      // nanoseconds, for the mean
+      std::uint64_t LifetimeMin;                        // nanoseconds
+      std::uint64_t LifetimeMax;                        // nanoseconds
+      std::uint64_t Lifetimes[LIFETIME_BUCKETS];        // frees by log2 of the lifetime in nanoseconds
+    };
+
+    // A sampled object that is still out with the client
+    struct LiveSample
+    {
+      size_t Site;          // index into Sites_
+      std::uint64_t Time;   // when it was allocated
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    unsigned SampleRate_;                              // one in how many allocations are sampled
+    std::uint64_t BucketNanoseconds_;                  // width of each rate bucket
+    std::atomic<std::int64_t> Start_;                  // time 0 for every timestamp, in Clock nanoseconds
+    mutable std::mutex Lock_;                          // guards everything below
+    std::vector<Site> Sites_;                          // every site seen so far
+    std::unordered_map<std::string, size_t> LabelIndex_;     // label text to Sites_
+    std::unordered_map<const void*, size_t> CallSiteIndex_;  // call sites without a label to Sites_
+    std::unordered_map<const void*, LiveSample> Live_;   // sampled objects not freed yet
+    std::vector<std::uint64_t> AllocationSeries_;      // sampled allocations per bucket
+    std::vector<std::uint64_t> FreeSeries_;            // sampled frees per bucket
+    std::atomic<std::uint16_t> Filter_[FILTER_SIZE];   // live samples per address hash, 0 means not sampled
+
+    std::uint64_t get_time(void) const;                         // nanoseconds since Start_
+    static std::int64_t get_clock(void);                        // nanoseconds on Clock
+    static size_t get_filter_slot(const void *Object);          // hashes an address into Filter_
+    void record_lifetime(Site &Sampled, std::uint64_t Lifetime); // counts a sampled object's free at its site
+    static void add_to_series(std::vector<std::uint64_t> &Series, size_t Bucket); // counts one event in a bucket
+    static void write_json_string(std::ostream &out, const std::string &Text); // quotes and escapes a string
+
+    // Make private to prevent copy construction and assignment
+    AllocationProfiler(const AllocationProfiler &ap);
+    AllocationProfiler &operator=(const AllocationProfiler &ap);
+
+};
+
+#endif
@@ -0,0 +1,234 @@
+/*!*************************************************************************************************
+\file    HandleAllocator.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the HandleAllocator.
+***************************************************************************************************/
+
+#include "HandleAllocator.h"  // HandleAllocator
+#include <algorithm>          // std::sort, std::binary_search
+#include <cstring>            // memcpy, memset
+
+// Creates the allocator and an empty handle table
+// Throws an exception if the construction fails. (Memory allocation problem)
+HandleAllocator::HandleAllocator(size_t ObjectSize, const OAConfig &config) : Allocator_(ObjectSize, get_config(config)),
+                                 FreeSlots_(NO_SLOT), LiveHandles_(0)
+{
+}
+
+// Gets an object and a handle to it
+// Throws an exception if the object can't be allocated. (Memory allocation problem)
+HandleAllocator::Handle HandleAllocator::Allocate(const char *label)
+{
+  void* object = Allocator_.Allocate(label);
+  std::uint32_t index = FreeSlots_;
+
+  // Reuse a free slot, or grow the table
+  if (index != NO_SLOT)
+    FreeSlots_ = Table_[index].NextFree;
+  else
+  {
+    try
+    {
+      // Every index has to fit beside the generation, and NO_SLOT can't be one
+      if (Table_.size() >= NO_SLOT)
+        throw OAException(OAException::E_NO_PAGES, "Out of handles!");
+
+      index = static_cast<std::uint32_t>(Table_.size());
+
+      Slot slot = { nullptr, 1, NO_SLOT };
+      Table_.push_back(slot);
+    }
+    catch (std::bad_alloc&)
+    {
+      Allocator_.Free(object);
+      throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+    }
+    catch (OAException&)
+    {
+      Allocator_.Free(object);
+      throw;
+    }
+  }
+
+  Table_[index].Object = object;
+  ++LiveHandles_;
+
+  return (Handle(Table_[index].Generation) << INDEX_BITS) | index;
+}
+
+// Frees the object behind a handle, the handle and any copies of it go stale
+// Throws an exception if the handle is bad or stale. (Invalid object)
+void HandleAllocator::Free(Handle Object)
+{
+  Handle index = Object & INDEX_MASK;
+
+  // Never handed out
+  if (Object == NULL_HANDLE || index >= Table_.size())
+    throw OAException(OAException::E_BAD_BOUNDARY, "Handle is not in the handle table!");
+
+  Slot& slot = Table_[index];
+
+  // The slot has moved on to another object, or to none
+  if (slot.Generation != (Object >> INDEX_BITS) || slot.Object == nullptr)
+    throw OAException(OAException::E_MULTIPLE_FREE, "Handle has already been freed!");
+
+  Allocator_.Free(slot.Object);
+  slot.Object = nullptr;
+  --LiveHandles_;
+
+  // Out of generations, reusing it would let the oldest handles match again, so it's never handed out
+  if (slot.Generation == LAST_GENERATION)
+    return;
+
+  // Copies of the handle no longer match
+  ++slot.Generation;
+  slot.NextFree = FreeSlots_;
+  FreeSlots_ = static_cast<std::uint32_t>(index);
+}
+
+// Moves live objects off the emptiest pages and releases every empty page, returns the number of pages freed
+unsigned HandleAllocator::Compact(RELOCATECALLBACK fn)
+{
+  ObjectAllocator& oa = Allocator_;
+
+  // No pages to compact
+  if (oa.Configuration_.UseCPPMemManager_)
+    return 0;
+
+  // Lazy objects nobody has touched yet would be missed when the free list is rebuilt
+  while (oa.CarvePage_ != nullptr)
+    oa.carve_object();
+
+  // The fewest pages that can hold every live object
+  unsigned perPage = oa.Configuration_.ObjectsPerPage_;
+  size_t needed = (oa.Statistics_.ObjectsInUse_ + perPage - 1) / perPage;
+
+  // Keep the fullest pages, the rest get emptied out
+  std::vector<char*> pages = oa.PageIndex_;
+  std::stable_sort(pages.begin(), pages.end(), [&oa](const char* left, const char* right)
+  {
+    return *oa.get_live_count(left) > *oa.get_live_count(right);
+  });
+
+  std::vector<char*> evacuate(pages.begin() + needed, pages.end());
+  std::sort(evacuate.begin(), evacuate.end());
+
+  // Walk the table, since it's the only place that knows which handle points where
+  size_t target = 0;
+  bool moved = false;
+
+  for (size_t i = 0; i < Table_.size(); ++i)
+  {
+    char* object = static_cast<char*>(Table_[i].Object);
+    if (object == nullptr)
+      continue;
+
+    char* page = oa.find_page(object);
+    if (!std::binary_search(evacuate.begin(), evacuate.end(), page))
+      continue;
+
+    // The kept pages always have room for everything being moved
+    while (*oa.get_live_count(pages[target]) == perPage)
+      ++target;
+
+    Table_[i].Object = move_object(object, page, pages[target], fn);
+    moved = true;
+  }
+
+  // Blocks that were just filled are still on the free list, so build it again in address order
+  if (moved && oa.Configuration_.Policy_ == OAConfig::apFreeList)
+  {
+    oa.FreeList_ = nullptr;
+
+    for (size_t p = oa.PageIndex_.size(); p > 0; --p)
+    {
+      char* page = oa.PageIndex_[p - 1];
+
+      for (unsigned i = perPage; i > 0; --i)
+      {
+        if (oa.is_block_in_use(page, i - 1))
+          continue;
+
+        GenericObject* node = reinterpret_cast<GenericObject*>(oa.get_object(page, i - 1));
+        node->Next = oa.FreeList_;
+        oa.FreeList_ = node;
+      }
+    }
+  }
+
+  // The emptied pages go back along with any that were already empty
+  return oa.free_empty_pages();
+}
+
+/***************************************************************************************************
+  Testing/Debugging/Statistic methods
+***************************************************************************************************/
+
+// returns the allocator for dumps and validation
+const ObjectAllocator &HandleAllocator::GetAllocator(void) const
+{
+  return Allocator_;
+}
+
+// returns the statistics for the allocator
+OAStats HandleAllocator::GetStats(void) const
+{
+  return Allocator_.GetStats();
+}
+
+// returns how many handles are live
+size_t HandleAllocator::GetHandleCount(void) const
+{
+  return LiveHandles_;
+}
+
+/***************************************************************************************************
+  Private methods
+***************************************************************************************************/
+
+// turns off the modes handles can't use
+OAConfig HandleAllocator::get_config(const OAConfig &config)
+{
+  // Compact reaches into the pages, so every object has to be where the pages say it is
+  OAConfig handleConfig = config;
+  handleConfig.ThreadCacheSize_ = 0;
+  handleConfig.LockFree_ = false;
+  handleConfig.Region_ = false;
+
+  // A stale handle is already caught by its generation, and Compact rebuilds the free list from the block maps
+  handleConfig.QuarantineSize_ = 0;
+
+  return handleConfig;
+}
+
+// moves an object onto ToPage
+char *HandleAllocator::move_object(char *From, char *FromPage, char *ToPage, RELOCATECALLBACK fn)
+{
+  ObjectAllocator& oa = Allocator_;
+  const OAConfig& config = oa.Configuration_;
+  size_t size = oa.Statistics_.ObjectSize_;
+
+  char* to = oa.get_object(ToPage, oa.find_free_block(ToPage));
+
+  // Claim the new block before anything is in it
+  oa.take_from_page(ToPage, to);
+  if (config.DebugOn_)
+    memset(to, ObjectAllocator::ALLOCATED_PATTERN, size);
+
+  // The header goes with the object, wherever the layout keeps it
+  oa.move_header(FromPage, From, ToPage, to);
+
+  // Let the client move it, it might not be trivially copyable
+  if (fn != nullptr)
+    fn(to, From, size);
+  else
+    memcpy(to, From, size);
+
+  // The old block is free, same as if it had been through Free
+  if (config.DebugOn_)
+    memset(From, ObjectAllocator::FREED_PATTERN, size);
+  oa.give_to_page(FromPage, From);
+
+  return to;
+}
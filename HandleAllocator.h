@@ -0,0 +1,96 @@
+/*!*************************************************************************************************
+\file    HandleAllocator.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds an ObjectAllocator that hands out generation checked handles instead of
+         pointers, so its objects can be moved into dense pages with Compact.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef HANDLEALLOCATORH
+#define HANDLEALLOCATORH
+//--------------------------------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"  // ObjectAllocator, OAConfig, OAStats
+#include <cstdint>            // std::uint32_t, std::uint64_t
+#include <vector>             // std::vector
+
+// Clients keep handles, and look the object up each time they need it
+// Not thread safe, thread caching and the lock-free list are turned off
+class HandleAllocator
+{
+  public:
+
+    // The low 32 bits index the handle table, the high 32 are a generation that catches handles that
+    // outlived their object. A slot whose generation runs out is retired, so a stale handle never matches
+    typedef std::uint64_t Handle;
+    static const unsigned INDEX_BITS = 32;
+    static const Handle INDEX_MASK = (Handle(1) << INDEX_BITS) - 1;
+    static const Handle NULL_HANDLE = 0;  // never handed out
+
+    // Moves an object from one block to another (To, From, size of the object)
+    // Without one, Compact copies the bytes
+    typedef void (*RELOCATECALLBACK)(void *, void *, size_t);
+
+    // Creates the allocator and an empty handle table
+    // Throws an exception if the construction fails. (Memory allocation problem)
+    HandleAllocator(size_t ObjectSize, const OAConfig &config);
+
+    // Gets an object and a handle to it
+    // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    Handle Allocate(const char *label = 0);
+
+    // Frees the object behind a handle, the handle and any copies of it go stale
+    // Throws an exception if the handle is bad or stale. (Invalid object)
+    void Free(Handle Object);
+
+    // Returns the object behind a handle, nullptr if the handle is stale
+    void *Get(Handle Object) const
+    {
+      Handle index = Object & INDEX_MASK;
+
+      // One lookup, the generation says whether the slot still belongs to this handle
+      if (index >= Table_.size() || Table_[index].Generation != (Object >> INDEX_BITS))
+        return nullptr;
+
+      return Table_[index].Object;
+    }
+
+    // Moves live objects off the emptiest pages and releases every empty page, returns the number of pages freed
+    // Pointers from Get aren't valid after this, handles are
+    unsigned Compact(RELOCATECALLBACK fn = nullptr);
+
+    // Testing/Debugging/Statistic methods
+    const ObjectAllocator &GetAllocator(void) const;  // returns the allocator for dumps and validation
+    OAStats GetStats(void) const;                     // returns the statistics for the allocator
+    size_t GetHandleCount(void) const;                // returns how many handles are live
+
+  private:
+
+    // One entry per handle index, free entries are chained through NextFree
+    struct Slot
+    {
+      void *Object;             // the object, nullptr while the slot is free
+      std::uint32_t Generation; // bumped on every free, never 0 so no handle is NULL_HANDLE
+                                // (LAST_GENERATION=retired, never reused)
+      std::uint32_t NextFree;   // the next free slot (NO_SLOT=none)
+    };
+
+    static const std::uint32_t NO_SLOT = 0xFFFFFFFF;
+    static const std::uint32_t LAST_GENERATION = 0xFFFFFFFF;
+
+    ObjectAllocator Allocator_;  // where the objects live
+    std::vector<Slot> Table_;    // indexed by handle
+    std::uint32_t FreeSlots_;    // first free slot in the table (NO_SLOT=none)
+    size_t LiveHandles_;         // slots that hold an object
+
+    static OAConfig get_config(const OAConfig &config);           // turns off the modes handles can't use
+    char *move_object(char *From, char *FromPage, char *ToPage, RELOCATECALLBACK fn); // moves an object onto ToPage
+
+    // Make private to prevent copy construction and assignment
+    HandleAllocator(const HandleAllocator &ha);
+    HandleAllocator &operator=(const HandleAllocator &ha);
+
+};
+
+#endif
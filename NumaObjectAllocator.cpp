@@ -0,0 +1,155 @@
+/*!*************************************************************************************************
+\file    NumaObjectAllocator.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the NumaObjectAllocator.
+***************************************************************************************************/
+
+#include "NumaObjectAllocator.h"  // NumaObjectAllocator
+#include <new>                    // std::bad_alloc
+
+// Creates one pool per node, the config is used for every pool except for its PageSource_
+// Throws an exception if the construction fails. (Memory allocation problem)
+NumaObjectAllocator::NumaObjectAllocator(size_t ObjectSize, const OAConfig &config, size_t RegionBytes)
+{
+  // The system heap doesn't make pages, so there's nothing to place
+  const std::vector<unsigned>& nodes = NumaPageSource::GetNodes();
+  unsigned count = config.UseCPPMemManager_ ? 1 : static_cast<unsigned>(nodes.size());
+
+  try
+  {
+    // Nothing to route, so don't take over the config's source either
+    if (count == 1)
+    {
+      Pools_.push_back(nullptr);
+      Pools_[0] = new ObjectAllocator(ObjectSize, config);
+      return;
+    }
+
+    Sources_.reserve(count);
+    Pools_.reserve(count);
+
+    // Node IDs are in order, so the last is the highest, anything offline goes to the first pool
+    NodePools_.assign(nodes.back() + 1, 0);
+    for (unsigned i = 0; i < count; ++i)
+      NodePools_[nodes[i]] = i;
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+      Sources_.push_back(new NumaPageSource(nodes[i], RegionBytes));
+
+      // The same config, just getting its pages from this node
+      OAConfig nodeConfig = config;
+      nodeConfig.PageSource_ = Sources_[i];
+
+      Pools_.push_back(new ObjectAllocator(ObjectSize, nodeConfig));
+    }
+  }
+  catch (std::bad_alloc&)
+  {
+    destroy();
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+  catch (OAException&)
+  {
+    destroy();
+    throw;
+  }
+}
+
+// Destroys every pool, then the sources their pages came from (never throws)
+NumaObjectAllocator::~NumaObjectAllocator()
+{
+  destroy();
+}
+
+// Takes an object from the calling thread's node (simulates new)
+// Throws an exception if the object can't be allocated. (Memory allocation problem)
+void *NumaObjectAllocator::Allocate(const char *label)
+{
+  return Pools_[get_node()]->Allocate(label);
+}
+
+// Gives an object back to the node it came from, which may not be the caller's (simulates delete)
+// The owner is found from the address ranges of each node's regions, without taking a lock
+// Throws an exception if the object can't be freed. (Invalid object)
+void NumaObjectAllocator::Free(void *Object)
+{
+  // Nobody else it could belong to
+  if (Pools_.size() == 1)
+  {
+    Pools_[0]->Free(Object);
+    return;
+  }
+
+  // Most objects are freed on the node that allocated them, so ask that pool first
+  // Every pool has its own source, so the regions that hold the address name the owner without a lock
+  unsigned local = get_node();
+  if (Sources_[local]->Contains(Object))
+  {
+    Pools_[local]->Free(Object);
+    return;
+  }
+
+  for (unsigned i = 0; i < Pools_.size(); ++i)
+  {
+    if (i != local && Sources_[i]->Contains(Object))
+    {
+      Pools_[i]->Free(Object);
+      return;
+    }
+  }
+
+  // Not on any node's pages, let the local pool report it
+  Pools_[local]->Free(Object);
+}
+
+/***************************************************************************************************
+  Testing/Debugging/Statistic methods
+***************************************************************************************************/
+
+// returns how many pools there are
+unsigned NumaObjectAllocator::GetNodeCount(void) const
+{
+  return static_cast<unsigned>(Pools_.size());
+}
+
+// returns a pool for dumps and validation
+const ObjectAllocator &NumaObjectAllocator::GetAllocator(unsigned Pool) const
+{
+  return *Pools_[Pool < Pools_.size() ? Pool : 0];
+}
+
+// returns the statistics for a pool
+OAStats NumaObjectAllocator::GetStats(unsigned Pool) const
+{
+  return Pool < Pools_.size() ? Pools_[Pool]->GetStats() : OAStats();
+}
+
+/***************************************************************************************************
+  Private methods
+***************************************************************************************************/
+
+// the calling thread's pool
+unsigned NumaObjectAllocator::get_node(void) const
+{
+  if (Pools_.size() == 1)
+    return 0;
+
+  unsigned node = NumaPageSource::GetCurrentNode();
+  return node < NodePools_.size() ? NodePools_[node] : 0;
+}
+
+// deletes the pools, then the sources
+void NumaObjectAllocator::destroy(void)
+{
+  // A pool gives its pages back to its source as it goes, so the sources have to be last
+  for (size_t i = 0; i < Pools_.size(); ++i)
+    delete Pools_[i];
+  for (size_t i = 0; i < Sources_.size(); ++i)
+    delete Sources_[i];
+
+  Pools_.clear();
+  Sources_.clear();
+  NodePools_.clear();
+}
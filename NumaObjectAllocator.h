@@ -0,0 +1,64 @@
+/*!*************************************************************************************************
+\file    NumaObjectAllocator.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the public interface for the NumaObjectAllocator, one ObjectAllocator per
+         NUMA node, each with its pages bound to its own node's memory.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef NUMAOBJECTALLOCATORH
+#define NUMAOBJECTALLOCATORH
+//--------------------------------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"  // ObjectAllocator, OAConfig, OAStats
+#include "PageSource.h"       // NumaPageSource
+#include <vector>             // std::vector
+
+// Routes each allocation to the pool for the node the calling thread is on, so its pages are local
+// Every online node has its own pages and free list, frees go back to whichever pool owns the object
+// With one node (or UseCPPMemManager_) it's a single ObjectAllocator using the config as given
+// Finding the owner takes no lock, so it is as thread safe as the pools' config makes Allocate and Free
+class NumaObjectAllocator
+{
+  public:
+
+    // Creates one pool per node, the config is used for every pool except for its PageSource_
+    // Throws an exception if the construction fails. (Memory allocation problem)
+    NumaObjectAllocator(size_t ObjectSize, const OAConfig &config,
+                        size_t RegionBytes = MmapPageSource::DEFAULT_REGION_BYTES);
+
+    // Destroys every pool, then the sources their pages came from (never throws)
+    ~NumaObjectAllocator();
+
+    // Takes an object from the calling thread's node (simulates new)
+    // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    void *Allocate(const char *label = 0);
+
+    // Gives an object back to the node it came from, which may not be the caller's (simulates delete)
+    // The owner is found from the address ranges of each node's regions, without taking a lock
+    // Throws an exception if the object can't be freed. (Invalid object)
+    void Free(void *Object);
+
+    // Testing/Debugging/Statistic methods
+    // Pools are in node ID order, which can have gaps, so a pool's index isn't always its node's ID
+    unsigned GetNodeCount(void) const;                        // returns how many pools there are
+    const ObjectAllocator &GetAllocator(unsigned Pool) const; // returns a pool for dumps and validation
+    OAStats GetStats(unsigned Pool) const;                    // returns the statistics for a pool
+
+  private:
+
+    std::vector<NumaPageSource*> Sources_;  // one per pool, empty with a single pool
+    std::vector<ObjectAllocator*> Pools_;   // one per online node, in node ID order
+    std::vector<unsigned> NodePools_;       // the pool for each node ID up to the highest online one
+
+    unsigned get_node(void) const;  // the calling thread's pool
+    void destroy(void);             // deletes the pools, then the sources
+
+    // Make private to prevent copy construction and assignment
+    NumaObjectAllocator(const NumaObjectAllocator &noa);
+    NumaObjectAllocator &operator=(const NumaObjectAllocator &noa);
+
+};
+
+#endif
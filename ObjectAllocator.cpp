@@ -1,649 +1,2885 @@
-/*!*************************************************************************************************
-\file    ObjectAllocator.cpp
-\author  Seth Glaser
-\date    1/11/2017
-\par     Class: CS280-A
-\par     Email: seth.g\@digipen.edu
-\brief   This file holds the implementation for the ObjectAllocator.
-***************************************************************************************************/
-
-#include "ObjectAllocator.h"  // OAException, OAConfig, OAStats, ObjectAllocator
-#include "cstring"            // strcpy
-
-
-MemBlockInfo::MemBlockInfo(bool inUse, const char* userLabel, unsigned allocNumber) : in_use(inUse),
-                           label(nullptrptr), alloc_num(allocNumber)
-{
-  // Points at the allocated memory
-  char *newLabel = nullptrptr;
-  
-  // If there is a label from the user
-  if(userLabel != nullptrptr)
-  {
-    try
-    {
-      // Tries to allocate the memory
-      newLabel = new char[strlen(userLabel) + 1];
-    }
-    catch (std::bad_alloc&)
-    {
-      throw OAException(OAException::E_NO_MEMORY, "Out of memory for external header!");
-    }
-    
-    // Copies the user's label to the allocated memory and points at it
-    label = strcpy(newLabel, userLabel);
-  }
-
-}
-
-MemBlockInfo::~MemBlockInfo()
-{
-  // If there was a label allocated
-  if(label != nullptrptr)
-    delete[] label;
-
-  label = nullptrptr;
-}
-
-
-
-// Creates the ObjectManager per the specified values
-// Throws an exception if the construction fails. (Memory allocation problem)
-ObjectAllocator::ObjectAllocator(size_t ObjectSize, const OAConfig& config) : PageList_(nullptr),
-                                 FreeList_(nullptr), Configuration_(config)
-{
-  // Set the values of the Stats
-  Statistics_.ObjectSize_ = ObjectSize;
-  Statistics_.PageSize_ = get_size_of_header() + (get_size_of_object() * config.ObjectsPerPage_);
-
-  // Allocate the first page
-  allocate_new_page();
-
-}
-
-// Destroys the ObjectManager (never throws)
-ObjectAllocator::~ObjectAllocator()
-{
-  // While there are pages left
-	while(PageList_ != nullptr)
-	{
-		GenericObject* temp = PageList_;
-		PageList_ = PageList_->Next;
-
-		delete [] temp;
-	}
-}
-
-// Take an object from the free list and give it to the client (simulates new)
-// Throws an exception if the object can't be allocated. (Memory allocation problem)
-void *ObjectAllocator::Allocate(const char *label)
-{
-  // If they are using the CPPManager
-  if(Configuration_.UseCPPMemManager_)
-  {
-    // Adjust stats
-    Statistics_.Allocations_++;
-    Statistics_.ObjectsInUse_++;
-    Statistics_.FreeObjects_--;
-    if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
-      Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
-    
-    return operator new(Statistics_.ObjectSize_);
-  }
-
-  // If the free list isn't nullptr
-  if(FreeList_ == nullptr)
-  {
-    // Try to make a new page
-    allocate_new_page();
-  }
-
-  // Get the node to return
-  void* returnNode = FreeList_;
-
-  // Adjust the FreeList to look at the element after the returning node
-  FreeList_ = FreeList_->Next;
-  reinterpret_cast<GenericObject*>(returnNode)->Next = nullptr;
-
-  // Adjust stats
-  Statistics_.Allocations_++;
-  Statistics_.ObjectsInUse_++;
-  Statistics_.FreeObjects_--;
-  if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
-	  Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
-
-  // Add the correct signature
-  if(Configuration_.DebugOn_)
-    memset(returnNode, ALLOCATED_PATTERN, Statistics_.ObjectSize_);
-
-  // If there is a header
-  if(Configuration_.HBlockInfo_.type_ != OAConfig::hbNone)
-  {
-	 // If it's external
-  	if(Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
-		set_external_header(returnNode, label);
-	else
-		set_header_data(returnNode);
-
-  }
-
-  return returnNode;
-}
-
-// Returns an object to the free list for the client (simulates delete)
-// Throws an exception if the the object can't be freed. (Invalid object)
-void ObjectAllocator::Free(void *Object)
-{
-	// If they are using the CPPManager
-	if (Configuration_.UseCPPMemManager_)
-	{
-		// Adjust stats
-		Statistics_.ObjectsInUse_--;
-		Statistics_.FreeObjects_++;
-		Statistics_.Deallocations_++;
-
-		// Free the object
-		free(Object);
-
-		return;
-	}
-
-  // Do error checking
-  if (Configuration_.DebugOn_)
-  {
-    check_within_bounds(Object);
-    check_double_free(Object);
-    if (Configuration_.PadBytes_ > 0)
-      check_corrputed_pad(Object);
-
-	// Add the correct signatures
-	memset(Object, FREED_PATTERN, Statistics_.ObjectSize_);
-  }
-  
-  if(Configuration_.HBlockInfo_.type_ != OAConfig::hbNone)
-    free_header_data(Object);
-
-  // Put it on the list
-  put_on_freelist(Object);
-
-}
-
-// Calls the callback fn for each block still in use
-unsigned ObjectAllocator::DumpMemoryInUse(DUMPCALLBACK fn) const
-{
-  // Walk through the pages
-  GenericObject* pageWalker = PageList_;
-  // Counts the number of leaks
-  unsigned counter = 0;
-  
-  // While there are pages left
-  while(pageWalker != nullptr)
-  {
-    // For every item on the page
-    for(unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
-    {
-      // Walks through all the objects in a single page
-      GenericObject* objectWalker =
-	    reinterpret_cast<GenericObject*>(reinterpret_cast<char*>(pageWalker) + sizeof(void*) +
-		                                 Configuration_.PadBytes_ + Configuration_.HBlockInfo_.size_
-										 + (get_size_of_object() * i));
-      
-      // If the client still has the object
-      if(!is_on_free_list(objectWalker))
-      {
-        fn(reinterpret_cast<void*>(objectWalker), Statistics_.ObjectSize_);
-        
-        ++counter;
-      }
-    }
-    
-    // Move to the next page
-    pageWalker = pageWalker->Next;
-  }
-  
-  return counter;
-}
-
-// Calls the callback fn for each block that is potentially corrupted
-unsigned ObjectAllocator::ValidatePages(VALIDATECALLBACK fn) const
-{
-  // Walk through the pages
-  GenericObject* pageWalker = PageList_;
-  // Counts the number of leaks
-  unsigned counter = 0;
-  
-  // While there are pages left
-  while (pageWalker != nullptr)
-  {
-    // For every item on the page
-    for (unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
-    {
-      // Walks through all the objects in a single page
-      void* objectWalker =
-	    reinterpret_cast<void*>(reinterpret_cast<char*>(pageWalker) + sizeof(void*) +
-		                        Configuration_.PadBytes_ + Configuration_.HBlockInfo_.size_ +
-								(get_size_of_object() * i));
-      
-      // If the client still has the object
-      if (is_corrupted(objectWalker))
-      {
-        fn(reinterpret_cast<void*>(objectWalker), Statistics_.ObjectSize_);
-        
-        ++counter;
-      }
-    }
-    
-    // Move to the next page
-    pageWalker = pageWalker->Next;
-  }
-  
-  return counter;
-}
-
-// Frees all empty pages (extra credit)
-unsigned ObjectAllocator::FreeEmptyPages(void)
-{
-  return 0;
-}
-
-// Returns true if FreeEmptyPages and alignments are implemented
-bool ObjectAllocator::ImplementedExtraCredit(void)
-{
-  return false;
-}
-
-/***************************************************************************************************
-  Testing/Debugging/Statistic methods
-***************************************************************************************************/
-
-// true=enable, false=disable
-void ObjectAllocator::SetDebugState(bool State)
-{
-  Configuration_.DebugOn_ = State;
-}
-
-// returns a pointer to the internal free list
-const void *ObjectAllocator::GetFreeList(void) const
-{
-  return reinterpret_cast<void*>(FreeList_);
-}
-
-// returns a pointer to the internal page list
-const void *ObjectAllocator::GetPageList(void) const
-{
-  return reinterpret_cast<void*>(PageList_);
-}
-
-// returns the configuration parameters
-OAConfig ObjectAllocator::GetConfig(void) const
-{
-  return Configuration_;
-}
-
-// returns the statistics for the allocator
-OAStats ObjectAllocator::GetStats(void) const
-{
-  return Statistics_;
-}
-
-/***************************************************************************************************
-  Private methods
-***************************************************************************************************/
-
-// allocates another page of objects
-void ObjectAllocator::allocate_new_page()
-{
-  // Check to see if you need to throw or not
-  if (Statistics_.PagesInUse_ != 0 && Statistics_.PagesInUse_ == Configuration_.MaxPages_)
-    throw OAException(OAException::E_NO_PAGES, "Max pages have been made!");
-
-  // Allocate the memory
-  char *page = nullptr;
-
-  try
-  {
-    page = new char[Statistics_.PageSize_];
-  }
-  catch (std::bad_alloc&)
-  {
-    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
-  }
-
-  // Set the correct pattern bytes
-  if (Configuration_.DebugOn_)
-  {
-    memset(page, UNALLOCATED_PATTERN, Statistics_.PageSize_);
-    set_padding_bytes(page);
-    set_header_bytes(page);
-  }
-
-  // Set the page to look at the old head and become the new head
-  reinterpret_cast<GenericObject*>(page)->Next = PageList_;
-  PageList_ = reinterpret_cast<GenericObject*>(page);
-
-  // Adjust the statistics
-  Statistics_.PagesInUse_++;
-
-  // Space the pointers on the new page
-  allocate_objects(page);
-}
-
-void ObjectAllocator::allocate_objects(char *page)
-{
-  // For every object to be on the page
-  for(unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
-  {
-    // The beginning of each object
-    GenericObject* node =
-	  reinterpret_cast<GenericObject*>(page + get_size_of_header() + (get_size_of_object() * i) +
-	                                   Configuration_.HBlockInfo_.size_ + Configuration_.PadBytes_);
-
-    // Adjust the next pointer correctly
-    node->Next = FreeList_;
-	FreeList_ = node;
-
-  }
-
-  // Adjust stats
-  Statistics_.FreeObjects_ += Configuration_.ObjectsPerPage_;
-
-}
-
-// Puts Object onto the free list
-void ObjectAllocator::put_on_freelist(void* Object)
-{
-  // Have the object point to the head of the free list
-  reinterpret_cast<GenericObject*>(Object)->Next = FreeList_;
-
-  // Reset the head of the list
-  FreeList_ = reinterpret_cast<GenericObject*>(Object);
-
-  // Then, adjust stats
-  Statistics_.ObjectsInUse_--;
-  Statistics_.FreeObjects_++;
-  Statistics_.Deallocations_++;
-}
-
-void ObjectAllocator::check_double_free(void* Object)
-{
-  // Check if it's been freed already
-  GenericObject* walker = FreeList_;
-  
-  // Walking through the list
-  while (walker != nullptr)
-  {
-  	// If the two objects match
-  	if (walker == reinterpret_cast<GenericObject*>(Object))
-  	{
-		throw OAException(OAException::E_MULTIPLE_FREE, "Object has already been freed!");
-  	}
-  
-	walker = walker->Next;
-  }
-
-}
-
-void ObjectAllocator::check_within_bounds(void* Object)
-{
-  // This is called with one object that is trying to be freed
-
-  // Walk through the Page List
-  GenericObject* walker = PageList_;
-
-  while(walker != nullptr)
-  {
-	  // If the beginning of the object is after a page beginning
-	  if((reinterpret_cast<char*>(Object) > reinterpret_cast<char*>(walker)) &&
-	     (reinterpret_cast<char*>(Object) < reinterpret_cast<char*>(walker) + Statistics_.PageSize_))
-	  {
-		  // if the end of the object is before the end of the same page
-		  size_t test1 = reinterpret_cast<size_t>(Object) - reinterpret_cast<size_t>(walker) -
-		                 get_size_of_header() - Configuration_.PadBytes_ -
-						 Configuration_.HBlockInfo_.size_;
-		  size_t test2 = Statistics_.ObjectSize_ + (Configuration_.PadBytes_ * 2) +
-		                 Configuration_.HBlockInfo_.size_;
-						 
-		  if (!(test1 % test2))
-			  return;
-
-		  break;
-	  }
-	  
-	  walker = walker->Next;
-  }
-  
-  // The item was never within a single page
-  throw OAException(OAException::E_BAD_BOUNDARY, "Object is not on a page correctly!");
-
-}
-
-void ObjectAllocator::check_corrputed_pad(void* Object)
-{
-  // This will check the first padding
-  unsigned char *leftPad = reinterpret_cast<unsigned char*>(reinterpret_cast<char*>(Object) -
-                                                            Configuration_.PadBytes_);
-  // This will check the second padding
-  unsigned char *rightPad = reinterpret_cast<unsigned char*>(reinterpret_cast<char*>(Object) +
-                                                             Statistics_.ObjectSize_);
-
-  // Check if the bytes have been touched
-  for(unsigned i = 0; i < Configuration_.PadBytes_; ++i)
-  {
-    // If this char doesn't have the pattern
-    if(*leftPad != PAD_PATTERN)
-    {
-      throw OAException(OAException::E_CORRUPTED_BLOCK, "The boundaries of this object were corrupted!");
-    }
-    // If this char doesn't have the pattern
-    if (*rightPad != PAD_PATTERN)
-    {
-      throw OAException(OAException::E_CORRUPTED_BLOCK, "The boundaries of this object were corrupted!");
-    }
-    
-    // Move each pad checker forward 1 char
-    ++leftPad;
-    ++rightPad;
-  }
-
-}
-
-void ObjectAllocator::set_padding_bytes(char* Page)
-{
-  // Walks through the page
-  char* walker = reinterpret_cast<char*>(Page + get_size_of_header() + Configuration_.PadBytes_ +
-                                         Configuration_.HBlockInfo_.size_);
-
-  // While in the list
-  for(unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
-  {
-    // Set pad bytes behind the object
-    memset((walker - Configuration_.PadBytes_), PAD_PATTERN, Configuration_.PadBytes_);
-
-    // Set pad bytes ahead the object
-    memset((walker + Statistics_.ObjectSize_), PAD_PATTERN, Configuration_.PadBytes_);
-
-    // Move to the next object
-    walker += get_size_of_object();
-  }
-
-}
-
-void ObjectAllocator::set_header_bytes(char* Page)
-{
-  // Walks through the page
-  char* walker = reinterpret_cast<char*>(Page + get_size_of_header() +
-                                         Configuration_.HBlockInfo_.size_ + Configuration_.PadBytes_);
-  
-  // While in the list
-  for (unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
-  {
-    // If the header is external
-    if(Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
-    {
-      // Make a mem block info pointer
-	  reinterpret_cast<GenericObject*>(walker - Configuration_.HBlockInfo_.size_ -
-	                                   Configuration_.PadBytes_)->Next = nullptr;
-    }
-	else
-	{
-      // Set header for the object
-      memset((walker - Configuration_.PadBytes_ - Configuration_.HBlockInfo_.size_), 0,
-	         Configuration_.HBlockInfo_.size_);
-	}
-    
-	// Move to the next object
-	walker += get_size_of_object();
-  }
-}
-
-void ObjectAllocator::set_header_data(void* Object)
-{
-  // Set the "free" bit
-  bool *freeBit = reinterpret_cast<bool*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
-                                          - sizeof(bool));
-  *freeBit = true;
-
-  // Set the allocation number
-  int *allocations = reinterpret_cast<int*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
-                                            - sizeof(int) - sizeof(bool));
-  *allocations = Statistics_.Allocations_;
-
-  // If it's more than basic
-  if(Configuration_.HBlockInfo_.type_ != OAConfig::hbBasic)
-  {
-	  // Set the counter bits
-	  short *counter = reinterpret_cast<short*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
-	                                            - sizeof(int) - sizeof(bool) - sizeof(short));
-	  ++(*counter);
-
-	  // Clear the user's data
-	  void *userData = reinterpret_cast<bool*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
-	                                           - Configuration_.HBlockInfo_.size_);
-	  memset(userData, 0, (Configuration_.HBlockInfo_.size_ - sizeof(int) - sizeof(bool) - sizeof(short)));
-  }
-
-}
-
-void ObjectAllocator::set_external_header(void* Object, const char* label)
-{
-  // Create the new external header
-  MemBlockInfo *newInfo = new MemBlockInfo(true, label, Statistics_.Allocations_);
-
-  // Point at it
-  intptr_t* pointing = reinterpret_cast<intptr_t*>(reinterpret_cast<char*>(Object) -
-                                                   Configuration_.PadBytes_ -
-												   Configuration_.HBlockInfo_.size_);
-  intptr_t address = reinterpret_cast<intptr_t>(newInfo);
-  *pointing = address;
-}
-
-void ObjectAllocator::free_header_data(void* Object)
-{
-	// If the header is external
-	if(Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
-	{
-      // Get the pointer
-	  MemBlockInfo **externalHeader = reinterpret_cast<MemBlockInfo**>(reinterpret_cast<char*>(Object)
-	                                                                   - Configuration_.PadBytes_ -
-																	   Configuration_.HBlockInfo_.size_);
-	  
-	  // Delete this header
-	  delete *externalHeader;
-	  
-	  // Set the value of the pointer in the object to nullptr
-	  *externalHeader = nullptr;
-	}
-	else
-	{
-      // In case the header is Extended
-      short counter = 0;
-      
-      // Save the counter value
-      if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExtended)
-        counter = *reinterpret_cast<short*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
-	                                        - sizeof(int) - sizeof(bool) - sizeof(short));
-      
-      // Clear everything
-      memset((reinterpret_cast<char*>(Object) - Configuration_.PadBytes_ - Configuration_.HBlockInfo_.size_),
-	         0, Configuration_.HBlockInfo_.size_);
-      
-      // If the header was Extended
-      if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExtended)
-      {
-        short *newCounter = reinterpret_cast<short*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
-		                                             - sizeof(int) - sizeof(bool) - sizeof(short));
-        *newCounter = counter;
-      }
-	}
-
-}
-
-size_t ObjectAllocator::get_size_of_header()
-{
-  // This replaces using size of the void pointer
-  return sizeof(void*);
-}
-
-size_t ObjectAllocator::get_size_of_object() const
-{
-  // This will cover the full distance of one object
-  return Statistics_.ObjectSize_ + (Configuration_.PadBytes_ * 2) + Configuration_.HBlockInfo_.size_;
-}
-
-bool ObjectAllocator::is_on_free_list(void* Object) const
-{
-	// Checks against all objects in the free list
-	GenericObject* walker = FreeList_;
-
-	// Walking through the list
-	while (walker != nullptr)
-	{
-		// If the two objects match
-		if (walker == reinterpret_cast<GenericObject*>(Object))
-		{
-			// The data is on the free list
-			return true;
-		}
-
-		// Move to the next free item
-		walker = walker->Next;
-	}
-
-	// The client has the data
-	return false;
-}
-
-bool ObjectAllocator::is_corrupted(void* Object) const
-{
-	// This will check the first padding
-	unsigned char *leftPad = reinterpret_cast<unsigned char*>(reinterpret_cast<char*>(Object)
-	                                                          - Configuration_.PadBytes_);
-	// This will check the second padding
-	unsigned char *rightPad = reinterpret_cast<unsigned char*>(reinterpret_cast<char*>(Object)
-	                                                           + Statistics_.ObjectSize_);
-
-	// Check if the bytes have been touched
-	for (unsigned i = 0; i < Configuration_.PadBytes_; ++i)
-	{
-		// If this char doesn't have the pattern
-		if (*leftPad != PAD_PATTERN)
-		{
-			// The object is corrupted
-			return true;
-		}
-		// If this char doesn't have the pattern
-		if (*rightPad != PAD_PATTERN)
-		{
-			// The object is corrupted
-			return true;
-		}
-
-		// Move each pad checker forward 1 char
-		++leftPad;
-		++rightPad;
-	}
-
-	// The object is not corrupted
-	return false;
-}
-
+/*!*************************************************************************************************
+\file    ObjectAllocator.cpp
+\author  Seth Glaser
+\date    1/11/2017
+\par     Class: CS280-A
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the ObjectAllocator.
+***************************************************************************************************/
+
+#include "ObjectAllocator.h"  // OAException, OAConfig, OAStats, ObjectAllocator
+#include "cstring"            // strcpy
+#include <algorithm>          // std::upper_bound, std::binary_search, std::sort
+#include <cstdio>             // snprintf
+#include <new>                // std::bad_alloc
+#include <thread>             // std::thread
+#include <system_error>       // std::system_error
+
+#ifdef OA_PROFILING
+#include "AllocationProfiler.h" // AllocationProfiler
+#if defined(_MSC_VER)
+#include <intrin.h>           // _ReturnAddress
+#define OA_CALL_SITE() _ReturnAddress()
+#else
+#define OA_CALL_SITE() __builtin_return_address(0)
+#endif
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>        // _mm256_cmpeq_epi8, _mm256_movemask_epi8
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>        // _mm_cmpeq_epi8, _mm_movemask_epi8
+#define OA_HAS_SSE2 1
+#endif
+
+
+MemBlockInfo::MemBlockInfo(bool inUse, const char* userLabel, unsigned allocNumber) : in_use(inUse),
+                           label(nullptr), alloc_num(allocNumber)
+{
+  // Points at the allocated memory
+  char *newLabel = nullptr;
+  
+  // If there is a label from the user
+  if(userLabel != nullptr)
+  {
+    try
+    {
+      // Tries to allocate the memory
+      newLabel = new char[strlen(userLabel) + 1];
+    }
+    catch (std::bad_alloc&)
+    {
+      throw OAException(OAException::E_NO_MEMORY, "Out of memory for external header!");
+    }
+    
+    // Copies the user's label to the allocated memory and points at it
+    label = strcpy(newLabel, userLabel);
+  }
+
+}
+
+MemBlockInfo::~MemBlockInfo()
+{
+  // If there was a label allocated
+  if(label != nullptr)
+    delete[] label;
+
+  label = nullptr;
+}
+
+// One thread's cache of free objects for one allocator
+struct ObjectAllocator::Magazine
+{
+  Magazine() : Objects(nullptr), Count(0), Allocations(0), Deallocations(0), Owned(false) {}
+
+  std::mutex Lock;          // only contended while another thread flushes or reads stats
+  GenericObject *Objects;   // the free objects this thread is holding
+  unsigned Count;           // how many objects are in the magazine
+  unsigned Allocations;     // requests this magazine handled
+  unsigned Deallocations;   // frees this magazine handled
+  bool Owned;               // a live thread is using this magazine (guarded by DepotLock_)
+};
+
+// Every thread caching allocator that is still alive, so exiting threads know where to give objects back
+static std::mutex RegistryLock;
+static std::vector<ObjectAllocator*> Registry;
+static unsigned long long NextAllocatorId = 1;
+
+// The magazines a single thread is holding, handed back when the thread exits
+class ThreadCacheTable
+{
+  public:
+    ~ThreadCacheTable();
+
+    ObjectAllocator::Magazine *find(unsigned long long Id) const;  // this thread's magazine for an allocator
+    void add(unsigned long long Id, ObjectAllocator::Magazine *Cache);
+
+  private:
+    struct Entry
+    {
+      unsigned long long Id;
+      ObjectAllocator::Magazine *Cache;
+    };
+
+    std::vector<Entry> Entries_;
+
+    static ObjectAllocator *find_allocator(unsigned long long Id);  // needs RegistryLock held
+};
+
+static thread_local ThreadCacheTable ThreadCaches;
+
+// Each thread sticks to one telemetry shard, handed out in turn so threads started together don't share
+static std::atomic<unsigned> NextTelemetryShard(0);
+static thread_local unsigned TelemetryShardIndex = ~0u;
+
+// The lock-free list head keeps a tag in the bits a user space pointer doesn't use (48-bit on 64-bit)
+// 5-level paging can hand out higher addresses, so allocate_new_page turns those pages down in lock-free mode.
+// The 16-bit tag only has to outlast one thread stalled between its load and its CAS, not the list's lifetime.
+static const unsigned HEAD_TAG_SHIFT = sizeof(void*) == 8 ? 48 : 32;
+static const std::uint64_t HEAD_POINTER_MASK = (std::uint64_t(1) << HEAD_TAG_SHIFT) - 1;
+
+// Checks that Count bytes all hold Pattern, a vector at a time where the target has them
+static bool is_filled(const unsigned char *Bytes, size_t Count, unsigned char Pattern)
+{
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256i wide = _mm256_set1_epi8(static_cast<char>(Pattern));
+  for (; i + 32 <= Count; i += 32)
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(Bytes + i)),
+                                               wide)) != -1)
+      return false;
+#endif
+
+#if defined(OA_HAS_SSE2)
+  const __m128i narrow = _mm_set1_epi8(static_cast<char>(Pattern));
+  for (; i + 16 <= Count; i += 16)
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Bytes + i)),
+                                         narrow)) != 0xFFFF)
+      return false;
+#endif
+
+  // A word at a time, then whatever is left
+  const std::uint64_t pattern = 0x0101010101010101ull * Pattern;
+  for (; i + sizeof(pattern) <= Count; i += sizeof(pattern))
+  {
+    std::uint64_t word;
+    memcpy(&word, Bytes + i, sizeof(word));
+    if (word != pattern)
+      return false;
+  }
+
+  for (; i < Count; ++i)
+    if (Bytes[i] != Pattern)
+      return false;
+
+  return true;
+}
+
+ThreadCacheTable::~ThreadCacheTable()
+{
+  // Holding the registry lock keeps the allocators from being destroyed under us
+  std::lock_guard<std::mutex> registry(RegistryLock);
+
+  for (size_t i = 0; i < Entries_.size(); ++i)
+  {
+    ObjectAllocator *owner = find_allocator(Entries_[i].Id);
+
+    // The allocator might already be gone, taking the magazine with it
+    if (owner != nullptr)
+      owner->release_magazine(Entries_[i].Cache);
+  }
+}
+
+ObjectAllocator::Magazine *ThreadCacheTable::find(unsigned long long Id) const
+{
+  // A thread rarely uses more than a handful of allocators
+  for (size_t i = 0; i < Entries_.size(); ++i)
+    if (Entries_[i].Id == Id)
+      return Entries_[i].Cache;
+
+  return nullptr;
+}
+
+void ThreadCacheTable::add(unsigned long long Id, ObjectAllocator::Magazine *Cache)
+{
+  std::lock_guard<std::mutex> registry(RegistryLock);
+
+  // Forget about allocators that have been destroyed since
+  size_t live = 0;
+  for (size_t i = 0; i < Entries_.size(); ++i)
+    if (find_allocator(Entries_[i].Id) != nullptr)
+      Entries_[live++] = Entries_[i];
+  Entries_.resize(live);
+
+  Entry entry = { Id, Cache };
+  Entries_.push_back(entry);
+}
+
+ObjectAllocator *ThreadCacheTable::find_allocator(unsigned long long Id)
+{
+  for (size_t i = 0; i < Registry.size(); ++i)
+    if (Registry[i]->Id_ == Id)
+      return Registry[i];
+
+  return nullptr;
+}
+
+
+
+// Creates the ObjectManager per the specified values
+// Throws an exception if the construction fails. (Memory allocation problem)
+ObjectAllocator::ObjectAllocator(size_t ObjectSize, const OAConfig& config) : PageList_(nullptr),
+                                 FreeList_(nullptr), EmptyPages_(0), CarvePage_(nullptr), CarveNext_(0),
+                                 RegionIndex_(0), RegionNext_(0), QuarantineHead_(0), QuarantineCount_(0),
+                                 Configuration_(config),
+                                 UseThreadCache_(false), Id_(0),
+                                 LockFree_(config.LockFree_ && config.ThreadCacheSize_ == 0 && !config.Region_ &&
+                                           config.QuarantineSize_ == 0 &&
+                                           !config.UseCPPMemManager_ && config.HBlockInfo_.type_ == OAConfig::hbNone),
+                                 LockFreeHead_(0), LockFreeAllocations_(0), LockFreeDeallocations_(0),
+                                 TelemetryReset_(0), TelemetryPages_(0), TelemetryMostPages_(0), TelemetryPagesFreed_(0),
+                                 SystemDebug_(config.UseCPPMemManager_ && config.DebugOn_)
+{
+  // Set the values of the Stats
+  Statistics_.ObjectSize_ = ObjectSize;
+  for (unsigned i = 0; i < TELEMETRY_SHARDS; ++i)
+  {
+    TelemetryShards_[i].Allocations.store(0, std::memory_order_relaxed);
+    TelemetryShards_[i].Deallocations.store(0, std::memory_order_relaxed);
+  }
+
+  // Without a source, every page is its own heap allocation
+  if (Configuration_.PageSource_ == nullptr)
+    Configuration_.PageSource_ = HeapPageSource::GetDefault();
+
+  // Every object has to be on the lock-free list from the start
+  if (LockFree_)
+  {
+    Configuration_.LazyCarving_ = false;
+    Configuration_.Policy_ = OAConfig::apFreeList;
+  }
+
+  // The block maps already say which objects are free, so there is nothing to carve
+  if (Configuration_.Policy_ == OAConfig::apFullestPage)
+    Configuration_.LazyCarving_ = false;
+
+  // A region bumps through its pages in order, and Reset can't stop to delete external headers
+  if (Configuration_.Region_)
+  {
+    Configuration_.LazyCarving_ = false;
+    Configuration_.Policy_ = OAConfig::apFreeList;
+    if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+      Configuration_.HeaderLayout_ = OAConfig::hlSideTable;
+  }
+
+  // The quarantine only matters when freed objects are reused, and has to keep them off the block maps' free lists
+  if (Configuration_.Region_ || Configuration_.UseCPPMemManager_)
+    Configuration_.QuarantineSize_ = 0;
+  if (Configuration_.QuarantineSize_ > 0)
+  {
+    Configuration_.Policy_ = OAConfig::apFreeList;
+
+    try
+    {
+      Quarantine_.resize(Configuration_.QuarantineSize_);
+    }
+    catch (std::bad_alloc&)
+    {
+      throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+    }
+  }
+
+  // Side table headers make the page header bigger, so they have to be placed first
+  set_side_table();
+
+  // Work out the alignment bytes so that every object lands on the boundary
+  Configuration_.LeftAlignSize_ = 0;
+  Configuration_.InterAlignSize_ = 0;
+  if (Configuration_.Alignment_ > 1)
+  {
+    // Everything in front of the first object and the distance between objects
+    size_t leftSide = get_size_of_header() + get_inline_header_size() + Configuration_.PadBytes_;
+    size_t block = get_size_of_object();
+
+    Configuration_.LeftAlignSize_ = static_cast<unsigned>((Configuration_.Alignment_ - (leftSide % Configuration_.Alignment_))
+                                                          % Configuration_.Alignment_);
+    Configuration_.InterAlignSize_ = static_cast<unsigned>((Configuration_.Alignment_ - (block % Configuration_.Alignment_))
+                                                           % Configuration_.Alignment_);
+  }
+
+  // The last object doesn't need alignment bytes after it
+  Statistics_.PageSize_ = get_size_of_header() + Configuration_.LeftAlignSize_ +
+                          (get_size_of_object() * config.ObjectsPerPage_) - Configuration_.InterAlignSize_;
+
+  // Allocate the first page, the system heap doesn't need any
+  if (!Configuration_.UseCPPMemManager_)
+    allocate_new_page();
+
+  // Its objects live on the lock-free list instead
+  if (LockFree_)
+    publish_free_list();
+
+  // Let threads find their way back to this allocator when they exit
+  if (Configuration_.ThreadCacheSize_ > 0)
+  {
+    std::lock_guard<std::mutex> registry(RegistryLock);
+
+    try
+    {
+      Registry.push_back(this);
+    }
+    catch (std::bad_alloc&)
+    {
+      if (PageList_ != nullptr)
+        delete_page(reinterpret_cast<char*>(PageList_));
+      throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+    }
+
+    Id_ = NextAllocatorId++;
+  }
+
+  update_thread_cache_state();
+
+}
+
+// Destroys the ObjectManager (never throws)
+ObjectAllocator::~ObjectAllocator()
+{
+  // Exiting threads can no longer give objects back to us
+  if (Configuration_.ThreadCacheSize_ > 0)
+  {
+    std::lock_guard<std::mutex> registry(RegistryLock);
+
+    Registry.erase(std::find(Registry.begin(), Registry.end(), this));
+
+    for (size_t i = 0; i < Magazines_.size(); ++i)
+      delete Magazines_[i];
+  }
+
+
+  // While there are pages left
+	while(PageList_ != nullptr)
+	{
+		GenericObject* temp = PageList_;
+		PageList_ = PageList_->Next;
+
+		delete_page(reinterpret_cast<char*>(temp));
+	}
+
+  // Same as the pages, whatever the client still has goes with the allocator
+  for (std::unordered_set<void*>::iterator it = SystemObjects_.begin(); it != SystemObjects_.end(); ++it)
+    release_system_block(static_cast<char*>(*it) - get_system_offset());
+}
+
+// Take an object from the free list and give it to the client (simulates new)
+// Throws an exception if the object can't be allocated. (Memory allocation problem)
+void *ObjectAllocator::Allocate(const char *label)
+{
+  void* object = allocate_object(label);
+  get_telemetry_shard().Allocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef OA_PROFILING
+  // Only the sampled allocations go near the profiler's lock
+  AllocationProfiler* profiler = Configuration_.Profiler_;
+  if (profiler != nullptr && profiler->ShouldSample())
+    profiler->RecordAllocate(object, Statistics_.ObjectSize_, label, OA_CALL_SITE());
+#endif
+
+  return object;
+}
+
+// Returns an object to the free list for the client (simulates delete)
+// Throws an exception if the the object can't be freed. (Invalid object)
+void ObjectAllocator::Free(void *Object)
+{
+  // Counted inside, as soon as the object is released, so nothing thrown after that can skip it
+  free_object(Object);
+}
+
+// Allocate without the profiler
+void *ObjectAllocator::allocate_object(const char *label)
+{
+  // When thread caching, go through this thread's magazine or take the shared lock
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+  {
+    if (UseThreadCache_.load(std::memory_order_relaxed))
+      return allocate_cached();
+
+    depot.lock();
+  }
+
+  // Shared between threads without a lock
+  if (LockFree_)
+    return allocate_lock_free();
+
+  // If they are using the CPPManager
+  if(Configuration_.UseCPPMemManager_)
+    return allocate_system();
+
+  // Copy a new label before taking anything, so running out of memory leaves nothing half done
+  unsigned labelId = 0;
+  if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable && Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+    labelId = intern_label(label);
+
+  // Bump along the region's pages instead of using the free list
+  if (Configuration_.Region_)
+    return allocate_region(labelId);
+
+  // If the free list isn't nullptr
+  if(FreeList_ == nullptr)
+  {
+    // Try to carve an object or make a new page
+    refill_free_list();
+  }
+
+  // Get the node to return
+  void* returnNode = FreeList_;
+
+  // Adjust the FreeList to look at the element after the returning node
+  FreeList_ = FreeList_->Next;
+  reinterpret_cast<GenericObject*>(returnNode)->Next = nullptr;
+
+  // Adjust stats
+  Statistics_.Allocations_++;
+  Statistics_.ObjectsInUse_++;
+  Statistics_.FreeObjects_--;
+  if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
+	  Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
+
+  // The page has one more object out with the client
+  char* page = find_page(returnNode);
+  take_from_page(page, returnNode);
+
+  // Add the correct signature
+  if(Configuration_.DebugOn_)
+    memset(returnNode, ALLOCATED_PATTERN, Statistics_.ObjectSize_);
+
+  // If there is a header
+  if(Configuration_.HBlockInfo_.type_ != OAConfig::hbNone)
+  {
+    // If it's in the page header
+    if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable)
+      set_side_header(page, returnNode, labelId);
+	 // If it's external
+  	else if(Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+		set_external_header(returnNode, label);
+	else
+		set_header_data(returnNode);
+
+  }
+
+  return returnNode;
+}
+
+// Free without the profiler
+void ObjectAllocator::free_object(void *Object)
+{
+  // When thread caching, go through this thread's magazine or take the shared lock
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+  {
+    if (UseThreadCache_.load(std::memory_order_relaxed))
+    {
+      free_cached(Object);
+      record_free(Object);
+      return;
+    }
+
+    depot.lock();
+  }
+
+  // Shared between threads without a lock
+  if (LockFree_)
+  {
+    free_lock_free(Object);
+    record_free(Object);
+    return;
+  }
+
+	// If they are using the CPPManager
+	if (Configuration_.UseCPPMemManager_)
+	{
+		free_system(Object);
+		record_free(Object);
+		return;
+	}
+
+  // Region objects only come back on Reset
+  if (Configuration_.Region_)
+  {
+    // A stale object from before the last Reset was already counted then
+    if (free_region(Object))
+      record_free(Object);
+    return;
+  }
+
+  // The page the object came from
+  char *page = nullptr;
+
+  // Do error checking
+  if (Configuration_.DebugOn_)
+  {
+    page = check_within_bounds(Object);
+    check_double_free(page, Object);
+    if (Configuration_.PadBytes_ > 0)
+      check_corrputed_pad(Object);
+
+	// Add the correct signatures
+	memset(Object, FREED_PATTERN, Statistics_.ObjectSize_);
+  }
+  else
+  {
+    page = find_page(Object);
+
+    // Not even on one of our pages
+    if (page == nullptr)
+      throw OAException(OAException::E_BAD_BOUNDARY, "Object is not on a page correctly!");
+  }
+  
+  // If there is a header
+  if (Configuration_.HBlockInfo_.type_ != OAConfig::hbNone)
+  {
+    if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable)
+      free_side_header(page, Object);
+    else
+      free_header_data(Object);
+  }
+
+  // Held back so a use after free has time to show, its page only empties when the oldest one leaves
+  if (Configuration_.QuarantineSize_ > 0)
+    quarantine_object(page, Object);
+  else
+  {
+    // The block belongs to the allocator again
+    give_to_page(page, Object);
+
+    // Put it on the list
+    put_on_freelist(Object);
+    record_free(Object);
+  }
+
+  // Give memory back if too much of it is sitting idle, the quarantine may have just emptied a page
+  if (should_free_empty_pages())
+    free_empty_pages();
+
+}
+
+// Fills Objects with Count objects from the free list, all or nothing
+// Throws an exception if the objects can't be allocated. (Memory allocation problem)
+void ObjectAllocator::AllocateBatch(void **Objects, size_t Count)
+{
+  // Modes that need work per object just go through Allocate
+  if (!can_batch())
+  {
+    size_t i = 0;
+
+    try
+    {
+      for (; i < Count; ++i)
+        Objects[i] = Allocate();
+    }
+    catch (OAException&)
+    {
+      // Give back what we got so the client doesn't get half a batch
+      while (i > 0)
+        Free(Objects[--i]);
+
+      throw;
+    }
+
+    return;
+  }
+
+  // Make all the pages up front so nothing has to be undone
+  while (Statistics_.FreeObjects_ < Count)
+    allocate_new_page();
+
+  // Take the first Count objects off the free list
+  for (size_t i = 0; i < Count; ++i)
+  {
+    // Lazy pages still have objects to carve
+    if (FreeList_ == nullptr)
+      refill_free_list();
+
+    GenericObject* object = FreeList_;
+    FreeList_ = object->Next;
+    object->Next = nullptr;
+
+    // The page has one more object out with the client
+    take_from_page(find_page(object), object);
+
+    // Add the correct signature
+    if (Configuration_.DebugOn_)
+      memset(object, ALLOCATED_PATTERN, Statistics_.ObjectSize_);
+
+    Objects[i] = object;
+  }
+
+  // Adjust stats once for the whole batch
+  Statistics_.Allocations_ += static_cast<unsigned>(Count);
+  Statistics_.ObjectsInUse_ += static_cast<unsigned>(Count);
+  Statistics_.FreeObjects_ -= static_cast<unsigned>(Count);
+  if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
+	  Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
+  get_telemetry_shard().Allocations.fetch_add(Count, std::memory_order_relaxed);
+}
+
+// Returns Count objects to the free list, the ones before a bad object are still freed
+// Throws an exception if one of the objects can't be freed. (Invalid object)
+void ObjectAllocator::FreeBatch(void * const *Objects, size_t Count)
+{
+  // Modes that need work per object just go through Free
+  if (!can_batch())
+  {
+    for (size_t i = 0; i < Count; ++i)
+      Free(Objects[i]);
+
+    return;
+  }
+
+  // The chain of freed objects, spliced onto the free list at the end
+  GenericObject* head = nullptr;
+  GenericObject* tail = nullptr;
+  unsigned freed = 0;
+
+  try
+  {
+    for (size_t i = 0; i < Count; ++i)
+    {
+      void* object = Objects[i];
+      char* page = nullptr;
+
+      // Do error checking, the block map catches the same object twice in one batch as well
+      if (Configuration_.DebugOn_)
+      {
+        page = check_within_bounds(object);
+        check_double_free(page, object);
+        if (Configuration_.PadBytes_ > 0)
+          check_corrputed_pad(object);
+
+        // Add the correct signatures
+        memset(object, FREED_PATTERN, Statistics_.ObjectSize_);
+      }
+      else
+      {
+        page = find_page(object);
+
+        // Not even on one of our pages
+        if (page == nullptr)
+          throw OAException(OAException::E_BAD_BOUNDARY, "Object is not on a page correctly!");
+      }
+
+      // The block belongs to the allocator again
+      give_to_page(page, object);
+
+      // Add it to the front of the chain
+      GenericObject* node = reinterpret_cast<GenericObject*>(object);
+      node->Next = head;
+      head = node;
+      if (tail == nullptr)
+        tail = node;
+      ++freed;
+    }
+  }
+  catch (OAException&)
+  {
+    // Keep the objects that were already checked
+    splice_onto_freelist(head, tail, freed);
+    throw;
+  }
+
+  splice_onto_freelist(head, tail, freed);
+
+  // Give memory back if too much of it is sitting idle
+  if (should_free_empty_pages())
+    free_empty_pages();
+}
+
+// Returns true if the address is somewhere on one of this allocator's pages
+bool ObjectAllocator::Owns(const void *Object) const
+{
+  // Keep other threads from adding pages while we look
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0 || LockFree_)
+    depot.lock();
+
+  // System heap objects can only be recognized when they're tracked
+  if (Configuration_.UseCPPMemManager_)
+    return SystemObjects_.count(const_cast<void*>(Object)) != 0;
+
+  return find_page(Object) != nullptr;
+}
+
+// Calls the callback fn for each block still in use
+unsigned ObjectAllocator::DumpMemoryInUse(DUMPCALLBACK fn) const
+{
+  // The system heap only knows its objects when they're tracked
+  if (Configuration_.UseCPPMemManager_)
+  {
+    std::vector<void*> objects;
+    get_system_objects(objects);
+
+    for (size_t i = 0; i < objects.size(); ++i)
+      fn(objects[i], Statistics_.ObjectSize_);
+
+    return static_cast<unsigned>(objects.size());
+  }
+
+  // Objects sitting in thread caches look taken to the pages, but the client doesn't have them
+  std::vector<Magazine*> caches;
+  std::vector<std::unique_lock<std::mutex> > locks;
+  std::vector<const void*> cached;
+
+  if (Configuration_.ThreadCacheSize_ > 0)
+  {
+    lock_magazines(caches, locks);
+    locks.push_back(std::unique_lock<std::mutex>(DepotLock_));
+
+    for (size_t i = 0; i < caches.size(); ++i)
+      for (GenericObject* walker = caches[i]->Objects; walker != nullptr; walker = walker->Next)
+        cached.push_back(walker);
+  }
+
+  // The lock-free list doesn't keep the block maps, so anything not on it is in use
+  if (LockFree_)
+  {
+    locks.push_back(std::unique_lock<std::mutex>(DepotLock_));
+
+    for (GenericObject* walker = unpack_head(LockFreeHead_.load()); walker != nullptr; walker = walker->Next)
+      cached.push_back(walker);
+  }
+
+  std::sort(cached.begin(), cached.end());
+
+  // Walk through the pages
+  GenericObject* pageWalker = PageList_;
+  // Counts the number of leaks
+  unsigned counter = 0;
+  
+  // While there are pages left
+  while(pageWalker != nullptr)
+  {
+    char *page = reinterpret_cast<char*>(pageWalker);
+
+    // For every item on the page that has been handed out (since the last Reset in a region)
+    unsigned carved = get_carved_count(page);
+    for(unsigned i = 0; i < carved; ++i)
+    {
+      // Walks through all the objects in a single page
+      GenericObject* objectWalker = reinterpret_cast<GenericObject*>(get_object(page, i));
+      
+      // If the client still has the object
+      if((LockFree_ || is_block_in_use(page, i)) &&
+         !std::binary_search(cached.begin(), cached.end(), objectWalker))
+      {
+        fn(reinterpret_cast<void*>(objectWalker), Statistics_.ObjectSize_);
+        
+        ++counter;
+      }
+    }
+    
+    // Move to the next page
+    pageWalker = pageWalker->Next;
+  }
+  
+  return counter;
+}
+
+// Calls the callback fn for each block that is potentially corrupted
+unsigned ObjectAllocator::ValidatePages(VALIDATECALLBACK fn) const
+{
+  // No pages, just the pads around each tracked object
+  if (Configuration_.UseCPPMemManager_)
+  {
+    std::vector<void*> objects;
+    get_system_objects(objects);
+
+    unsigned counter = 0;
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+      if (is_corrupted(objects[i]))
+      {
+        fn(objects[i], Statistics_.ObjectSize_);
+        ++counter;
+      }
+    }
+
+    return counter;
+  }
+
+  // Keep other threads from adding pages while we walk them
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0 || LockFree_)
+    depot.lock();
+
+  // Walk through the pages
+  GenericObject* pageWalker = PageList_;
+  // Counts the number of leaks
+  unsigned counter = 0;
+  
+  // While there are pages left
+  while (pageWalker != nullptr)
+  {
+    // For every item on the page that has been handed out at least once
+    char* page = reinterpret_cast<char*>(pageWalker);
+    unsigned carved = get_carved_count(page);
+    for (unsigned i = 0; i < carved; ++i)
+    {
+      // Walks through all the objects in a single page
+      void* objectWalker = get_object(page, i);
+      
+      // If the pads were touched, or a free object was written to
+      if (is_corrupted(objectWalker) || is_freed_overwritten(page, i))
+      {
+        fn(reinterpret_cast<void*>(objectWalker), Statistics_.ObjectSize_);
+        
+        ++counter;
+      }
+    }
+    
+    // Move to the next page
+    pageWalker = pageWalker->Next;
+  }
+  
+  return counter;
+}
+
+// Splits the pages between Threads workers (0=one per core), fn is still only called from this thread
+unsigned ObjectAllocator::ValidatePages(VALIDATECALLBACK fn, unsigned Threads) const
+{
+  // Nothing to split up
+  if (Configuration_.UseCPPMemManager_)
+    return ValidatePages(fn);
+
+  // Keep other threads from adding pages while we walk them
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0 || LockFree_)
+    depot.lock();
+
+  if (Threads == 0)
+    Threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  // No point in a worker without a page
+  size_t pages = PageIndex_.size();
+  if (Threads > pages)
+    Threads = static_cast<unsigned>(std::max(pages, size_t(1)));
+
+  // Each worker gets its own run of the index and its own list of bad objects
+  std::vector<std::vector<void*> > found(Threads);
+  std::vector<std::thread> workers;
+  auto work = [&](unsigned Worker)
+  {
+    for (size_t p = pages * Worker / Threads; p < pages * (Worker + 1) / Threads; ++p)
+      validate_page(PageIndex_[p], found[Worker]);
+  };
+
+  // If a thread can't be made, do its share here
+  for (unsigned i = 1; i < Threads; ++i)
+  {
+    try
+    {
+      workers.emplace_back(work, i);
+    }
+    catch (std::system_error&)
+    {
+      work(i);
+    }
+  }
+
+  work(0);
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+
+  // Report them in address order
+  unsigned counter = 0;
+  for (unsigned i = 0; i < Threads; ++i)
+  {
+    for (size_t j = 0; j < found[i].size(); ++j)
+      fn(found[i][j], Statistics_.ObjectSize_);
+
+    counter += static_cast<unsigned>(found[i].size());
+  }
+
+  return counter;
+}
+
+// Frees all empty pages (extra credit)
+unsigned ObjectAllocator::FreeEmptyPages(void)
+{
+  // A thread popping the lock-free list may still read a stale object, so pages have to stay
+  if (LockFree_)
+    return 0;
+
+  // Cached objects keep their pages alive, so hand them back first
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+  {
+    FlushThreadCaches();
+    depot.lock();
+  }
+
+  // A region's pages are only empty past its cursor
+  if (Configuration_.Region_)
+    return free_region_pages();
+
+  return free_empty_pages();
+}
+
+// Returns true if FreeEmptyPages and alignments are implemented
+bool ObjectAllocator::ImplementedExtraCredit(void)
+{
+  return true;
+}
+
+// Gives every thread's cached objects back to the shared free list
+void ObjectAllocator::FlushThreadCaches(void)
+{
+  // Nothing is cached
+  if (Configuration_.ThreadCacheSize_ == 0)
+    return;
+
+  // Magazines are only ever added, so a copy of the list is enough
+  std::vector<Magazine*> caches;
+  {
+    std::lock_guard<std::mutex> depot(DepotLock_);
+    caches = Magazines_;
+  }
+
+  // Each magazine is locked before the depot, same as on the fast path
+  for (size_t i = 0; i < caches.size(); ++i)
+  {
+    std::lock_guard<std::mutex> guard(caches[i]->Lock);
+    drain_magazine(caches[i], caches[i]->Count);
+  }
+}
+
+// Region mode: takes back every object at once and keeps the pages for the next cycle
+// O(1), or a pass over the used pages to put the signatures back when debugging
+// With OA_PROFILING the profiler forgets this allocator's sampled objects in one pass
+void ObjectAllocator::Reset(void)
+{
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+    depot.lock();
+
+  // Objects only come back one at a time
+  if (!Configuration_.Region_)
+    return;
+
+  // The blocks handed out this cycle look new again, so the checks still work next cycle
+  if (Configuration_.DebugOn_)
+  {
+    for (size_t p = 0; p < RegionPages_.size() && p <= RegionIndex_; ++p)
+    {
+      unsigned used = get_carved_count(RegionPages_[p]);
+      for (unsigned i = 0; i < used; ++i)
+        set_block_bytes(RegionPages_[p], i);
+    }
+  }
+
+  // Back to the first page, each page clears its block map when the cursor gets to it
+  RegionIndex_ = 0;
+  RegionNext_ = 0;
+
+#ifdef OA_PROFILING
+  // Every sampled object on the pages went with them, the profiler is shared so only ours are released
+  if (Configuration_.Profiler_ != nullptr)
+    Configuration_.Profiler_->RecordFreeAll(PageIndex_.data(), PageIndex_.size(), Statistics_.PageSize_);
+#endif
+
+  // Adjust stats, the telemetry never saw these objects come back through Free
+  TelemetryReset_.fetch_add(Statistics_.ObjectsInUse_, std::memory_order_relaxed);
+  Statistics_.FreeObjects_ = Statistics_.PagesInUse_ * Configuration_.ObjectsPerPage_;
+  Statistics_.ObjectsInUse_ = 0;
+}
+
+// Moves every quarantined object onto the free list, checking each one on the way
+// Throws an exception if one was written to and there is no UseAfterFree_. (Corrupted object)
+void ObjectAllocator::FlushQuarantine(void)
+{
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+    depot.lock();
+
+  // Empty the whole thing before reporting, so a throw doesn't leave anything behind
+  void* written = nullptr;
+  while (QuarantineCount_ > 0)
+  {
+    void* object = Quarantine_[QuarantineHead_];
+    QuarantineHead_ = (QuarantineHead_ + 1) % Quarantine_.size();
+    --QuarantineCount_;
+
+    if (!release_quarantined(object))
+    {
+      if (Configuration_.UseAfterFree_ != nullptr)
+        Configuration_.UseAfterFree_(object, Statistics_.ObjectSize_);
+      else if (written == nullptr)
+        written = object;
+    }
+  }
+
+  if (should_free_empty_pages())
+    free_empty_pages();
+
+  // Asked for, so throwing is fine, and the message says which object it was
+  if (written != nullptr)
+  {
+    char message[128];
+    snprintf(message, sizeof(message), "A freed object (%p) was written to while it was in quarantine!", written);
+    throw OAException(OAException::E_CORRUPTED_BLOCK, message);
+  }
+}
+
+/***************************************************************************************************
+  Testing/Debugging/Statistic methods
+***************************************************************************************************/
+
+// true=enable, false=disable
+void ObjectAllocator::SetDebugState(bool State)
+{
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+    depot.lock();
+
+  Configuration_.DebugOn_ = State;
+
+  // The checks need the shared lock, so debugging turns the thread caches off
+  update_thread_cache_state();
+}
+
+// returns a pointer to the internal free list
+const void *ObjectAllocator::GetFreeList(void) const
+{
+  if (LockFree_)
+    return reinterpret_cast<void*>(unpack_head(LockFreeHead_.load()));
+
+  return reinterpret_cast<void*>(FreeList_);
+}
+
+// returns a pointer to the internal page list
+const void *ObjectAllocator::GetPageList(void) const
+{
+  return reinterpret_cast<void*>(PageList_);
+}
+
+// returns the configuration parameters
+OAConfig ObjectAllocator::GetConfig(void) const
+{
+  return Configuration_;
+}
+
+// returns the statistics for the allocator
+OAStats ObjectAllocator::GetStats(void) const
+{
+  // The lock-free list only counts requests, the rest follows from them
+  if (LockFree_)
+  {
+    std::lock_guard<std::mutex> depot(DepotLock_);
+    OAStats stats = Statistics_;
+
+    // Read the frees first so they can't count objects the allocations miss
+    stats.Deallocations_ = LockFreeDeallocations_.load(std::memory_order_relaxed);
+    stats.Allocations_ = LockFreeAllocations_.load(std::memory_order_relaxed);
+
+    unsigned capacity = stats.PagesInUse_ * Configuration_.ObjectsPerPage_;
+    stats.ObjectsInUse_ = std::min(stats.Allocations_ - std::min(stats.Deallocations_, stats.Allocations_), capacity);
+    stats.FreeObjects_ = capacity - stats.ObjectsInUse_;
+
+    // The peak is only sampled on the lock-free list
+    if (stats.ObjectsInUse_ > stats.MostObjects_)
+      stats.MostObjects_ = stats.ObjectsInUse_;
+
+    return stats;
+  }
+
+  // Without thread caching everything is already in one place
+  if (Configuration_.ThreadCacheSize_ == 0)
+  {
+    OAStats stats = Statistics_;
+    stats.Fragmentation_ = get_fragmentation(stats);
+
+    return stats;
+  }
+
+  // Hold every magazine still so the totals add up
+  std::vector<Magazine*> caches;
+  std::vector<std::unique_lock<std::mutex> > locks;
+  lock_magazines(caches, locks);
+  std::lock_guard<std::mutex> depot(DepotLock_);
+
+  // The shared stats count cached objects as in use
+  OAStats stats = Statistics_;
+  for (size_t i = 0; i < caches.size(); ++i)
+  {
+    stats.Allocations_ += caches[i]->Allocations;
+    stats.Deallocations_ += caches[i]->Deallocations;
+    stats.FreeObjects_ += caches[i]->Count;
+    stats.ObjectsInUse_ -= caches[i]->Count;
+  }
+
+  // The peak is only sampled while thread caching
+  if (stats.ObjectsInUse_ > stats.MostObjects_)
+    stats.MostObjects_ = stats.ObjectsInUse_;
+
+  stats.Fragmentation_ = get_fragmentation(stats);
+
+  return stats;
+}
+
+// reads a block's header (false=no headers or not a block)
+bool ObjectAllocator::GetHeader(const void *Object, OAHeader &Header) const
+{
+  // Keep other threads from adding pages while we look
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+    depot.lock();
+
+  if (Configuration_.HBlockInfo_.type_ == OAConfig::hbNone || Configuration_.UseCPPMemManager_)
+    return false;
+
+  // Has to be the start of one of our blocks
+  char* page = find_page(Object);
+  if (page == nullptr || Object < get_object(page, 0))
+    return false;
+
+  unsigned index = get_block_index(page, Object);
+  if (index >= Configuration_.ObjectsPerPage_ || get_object(page, index) != Object)
+    return false;
+
+  Header.InUse = false;
+  Header.AllocNum = 0;
+  Header.UseCount = 0;
+  Header.Label = nullptr;
+  Header.UserData = nullptr;
+
+  // Lazy blocks nobody has touched yet have nothing in their headers
+  if (index >= get_carved_count(page))
+    return true;
+
+  OAConfig::HBLOCK_TYPE type = Configuration_.HBlockInfo_.type_;
+
+  // Everything is in the page header
+  if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable)
+  {
+    const char* table = get_side_table(page);
+
+    Header.InUse = table[SideTable_.Flags + index] != 0;
+    Header.AllocNum = reinterpret_cast<const unsigned*>(table + SideTable_.AllocNums)[index];
+
+    if (type == OAConfig::hbExtended)
+    {
+      Header.UseCount = reinterpret_cast<const unsigned short*>(table + SideTable_.UseCounts)[index];
+      Header.UserData = table + SideTable_.UserData + (index * Configuration_.HBlockInfo_.additional_);
+    }
+    else if (type == OAConfig::hbExternal)
+    {
+      unsigned id = reinterpret_cast<const unsigned*>(table + SideTable_.Labels)[index];
+      if (id != 0)
+        Header.Label = Labels_[id - 1].c_str();
+    }
+
+    return true;
+  }
+
+  const char* header = static_cast<const char*>(Object) - Configuration_.PadBytes_ - Configuration_.HBlockInfo_.size_;
+
+  // Just a pointer to the real header
+  if (type == OAConfig::hbExternal)
+  {
+    MemBlockInfo* info = nullptr;
+    memcpy(&info, header, sizeof(info));
+
+    if (info != nullptr)
+    {
+      Header.InUse = info->in_use;
+      Header.AllocNum = info->alloc_num;
+      Header.Label = info->label;
+    }
+
+    return true;
+  }
+
+  // The flag byte is last, the allocation number right before it
+  const char* flag = static_cast<const char*>(Object) - Configuration_.PadBytes_ - sizeof(bool);
+  Header.InUse = *flag != 0;
+  memcpy(&Header.AllocNum, flag - sizeof(int), sizeof(Header.AllocNum));
+
+  // The counter comes before that, and the user's bytes start the header
+  if (type == OAConfig::hbExtended)
+  {
+    memcpy(&Header.UseCount, flag - sizeof(int) - sizeof(short), sizeof(Header.UseCount));
+    Header.UserData = header;
+  }
+
+  return true;
+}
+
+// returns the lock-free counters, safe to call from any thread at any time
+OATelemetry ObjectAllocator::GetTelemetry(void) const
+{
+  OATelemetry telemetry;
+
+  // Frees first, so an object allocated and freed while we read can't look freed without being allocated
+  for (unsigned i = 0; i < TELEMETRY_SHARDS; ++i)
+    telemetry.Deallocations_ += TelemetryShards_[i].Deallocations.load(std::memory_order_relaxed);
+  std::uint64_t reset = TelemetryReset_.load(std::memory_order_relaxed);
+  for (unsigned i = 0; i < TELEMETRY_SHARDS; ++i)
+    telemetry.Allocations_ += TelemetryShards_[i].Allocations.load(std::memory_order_relaxed);
+
+  std::uint64_t returned = telemetry.Deallocations_ + reset;
+  telemetry.ObjectsInUse_ = telemetry.Allocations_ > returned ? telemetry.Allocations_ - returned : 0;
+
+  telemetry.PagesInUse_ = TelemetryPages_.load(std::memory_order_relaxed);
+  telemetry.MostPages_ = TelemetryMostPages_.load(std::memory_order_relaxed);
+  telemetry.PagesFreed_ = TelemetryPagesFreed_.load(std::memory_order_relaxed);
+
+  // The system heap holds one block per object, pages are held whole
+  telemetry.BytesUsed_ = static_cast<size_t>(telemetry.ObjectsInUse_) * Statistics_.ObjectSize_;
+  if (Configuration_.UseCPPMemManager_)
+  {
+    size_t block = SystemDebug_ ? get_system_offset() + Statistics_.ObjectSize_ + Configuration_.PadBytes_ : Statistics_.ObjectSize_;
+    telemetry.BytesReserved_ = static_cast<size_t>(telemetry.ObjectsInUse_) * block;
+  }
+  else
+    telemetry.BytesReserved_ = telemetry.PagesInUse_ * Statistics_.PageSize_;
+
+  // A snapshot taken mid-page can count objects on a page it hasn't seen yet
+  if (telemetry.BytesReserved_ > telemetry.BytesUsed_)
+    telemetry.OverheadRatio_ = static_cast<float>(telemetry.BytesReserved_ - telemetry.BytesUsed_) / telemetry.BytesReserved_;
+
+  return telemetry;
+}
+
+/***************************************************************************************************
+  Private methods
+***************************************************************************************************/
+
+// FreeEmptyPages without taking the lock
+unsigned ObjectAllocator::free_empty_pages(void)
+{
+  // Nothing to give back
+  if (EmptyPages_ == 0)
+    return 0;
+
+  // Pull every object that lives on an empty page off of the free list
+  GenericObject** link = &FreeList_;
+  char* lastPage = nullptr;
+
+  while (*link != nullptr)
+  {
+    // Objects from the same page tend to sit together on the list
+    char* page = lastPage;
+    if (page == nullptr || reinterpret_cast<char*>(*link) < page ||
+        reinterpret_cast<char*>(*link) >= page + Statistics_.PageSize_)
+      page = lastPage = find_page(*link);
+
+    // Skip over it if its page is going away
+    if (*get_live_count(page) == 0)
+      *link = (*link)->Next;
+    else
+      link = &(*link)->Next;
+  }
+
+  // Drop the empty pages out of the index, it stays sorted
+  std::vector<char*>::iterator end = PageIndex_.begin();
+  for (std::vector<char*>::iterator it = PageIndex_.begin(); it != PageIndex_.end(); ++it)
+    if (*get_live_count(*it) != 0)
+      *end++ = *it;
+  PageIndex_.erase(end, PageIndex_.end());
+
+  // Unlink and release the empty pages themselves
+  GenericObject** pageLink = &PageList_;
+  unsigned freed = 0;
+
+  while (*pageLink != nullptr)
+  {
+    GenericObject* page = *pageLink;
+
+    // Still has objects out with the client
+    if (*get_live_count(reinterpret_cast<char*>(page)) != 0)
+    {
+      pageLink = &page->Next;
+      continue;
+    }
+
+    // Nothing is left to carve from it either
+    if (reinterpret_cast<char*>(page) == CarvePage_)
+      CarvePage_ = nullptr;
+
+    // Empty pages sit in the first bin
+    if (Configuration_.Policy_ == OAConfig::apFullestPage)
+      remove_from_page_bin(reinterpret_cast<char*>(page), 0);
+
+    *pageLink = page->Next;
+    delete_page(reinterpret_cast<char*>(page));
+    ++freed;
+  }
+
+  // Adjust stats
+  Statistics_.PagesInUse_ -= freed;
+  Statistics_.FreeObjects_ -= freed * Configuration_.ObjectsPerPage_;
+  publish_pages(freed);
+  EmptyPages_ = 0;
+
+  return freed;
+}
+
+// allocates another page of objects
+void ObjectAllocator::allocate_new_page()
+{
+  // Check to see if you need to throw or not
+  if (Statistics_.PagesInUse_ != 0 && Statistics_.PagesInUse_ == Configuration_.MaxPages_)
+    throw OAException(OAException::E_NO_PAGES, "Max pages have been made!");
+
+  // Allocate the memory
+  char *page = nullptr;
+
+  try
+  {
+    page = static_cast<char*>(Configuration_.PageSource_->AcquirePage(Statistics_.PageSize_, get_page_alignment()));
+  }
+  catch (std::bad_alloc&)
+  {
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+
+  // The lock-free list head can only hold addresses below its tag
+  if (LockFree_ && reinterpret_cast<std::uintptr_t>(page) + Statistics_.PageSize_ - 1 > HEAD_POINTER_MASK)
+  {
+    Configuration_.PageSource_->ReleasePage(page, Statistics_.PageSize_, get_page_alignment());
+    throw OAException(OAException::E_NO_MEMORY, "Page is above the addresses the lock-free list can hold!");
+  }
+
+  // Set the correct pattern bytes, lazy pages only get the page header now and each block as it's carved
+  if (Configuration_.DebugOn_ && Configuration_.LazyCarving_)
+  {
+    memset(page, UNALLOCATED_PATTERN, get_size_of_header());
+    memset(page + get_size_of_header(), ALIGN_PATTERN, Configuration_.LeftAlignSize_);
+  }
+  else if (Configuration_.DebugOn_)
+  {
+    memset(page, UNALLOCATED_PATTERN, Statistics_.PageSize_);
+    set_padding_bytes(page);
+    set_alignment_bytes(page);
+    set_header_bytes(page);
+  }
+
+  // Every block on a new page starts out free
+  *get_live_count(page) = 0;
+  memset(get_block_map(page), 0, get_block_map_words() * sizeof(BlockMapWord));
+
+  // Side table headers start out cleared, a lazy page clears each block's as it's carved
+  if (!Configuration_.LazyCarving_)
+    memset(get_side_table(page), 0, SideTable_.Size);
+  ++EmptyPages_;
+
+  // Remember where the page lives before handing it out
+  try
+  {
+    // A region fills its pages in the order they were made, the bin slot holds the page's place
+    if (Configuration_.Region_)
+    {
+      RegionPages_.push_back(page);
+      *get_bin_slot(page) = static_cast<unsigned>(RegionPages_.size() - 1);
+    }
+
+    add_to_page_index(page);
+
+    // Make room in every bin up front, so moving pages between them never allocates
+    if (Configuration_.Policy_ == OAConfig::apFullestPage)
+      for (unsigned i = 0; i <= PARTIAL_BINS; ++i)
+        if (PageBins_[i].capacity() < PageIndex_.size())
+          PageBins_[i].reserve(PageIndex_.size() * 2);
+  }
+  catch (std::bad_alloc&)
+  {
+    if (!RegionPages_.empty() && RegionPages_.back() == page)
+      RegionPages_.pop_back();
+
+    delete_page(page);
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+
+  // Set the page to look at the old head and become the new head
+  reinterpret_cast<GenericObject*>(page)->Next = PageList_;
+  PageList_ = reinterpret_cast<GenericObject*>(page);
+
+  // Adjust the statistics
+  Statistics_.PagesInUse_++;
+  publish_pages(0);
+
+  // Nothing goes on the free list, the region hands out the page's objects in order
+  if (Configuration_.Region_)
+  {
+    Statistics_.FreeObjects_ += Configuration_.ObjectsPerPage_;
+    return;
+  }
+
+  // The block map is the free list, and every block on it starts out free
+  if (Configuration_.Policy_ == OAConfig::apFullestPage)
+  {
+    add_to_page_bin(page, 0);
+    Statistics_.FreeObjects_ += Configuration_.ObjectsPerPage_;
+    return;
+  }
+
+  // Space the pointers on the new page
+  if (!Configuration_.LazyCarving_)
+  {
+    allocate_objects(page);
+    return;
+  }
+
+  // The rest of the old page goes on the free list before the new one takes over
+  while (CarvePage_ != nullptr)
+    carve_object();
+
+  // Objects are carved off the front as they're needed, but they count as free already
+  CarvePage_ = page;
+  CarveNext_ = 0;
+  Statistics_.FreeObjects_ += Configuration_.ObjectsPerPage_;
+}
+
+void ObjectAllocator::allocate_objects(char *page)
+{
+  // For every object to be on the page
+  for(unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
+  {
+    // The beginning of each object
+    GenericObject* node = reinterpret_cast<GenericObject*>(get_object(page, i));
+
+    // Adjust the next pointer correctly
+    node->Next = FreeList_;
+	FreeList_ = node;
+
+  }
+
+  // Adjust stats
+  Statistics_.FreeObjects_ += Configuration_.ObjectsPerPage_;
+
+}
+
+// gets at least one object onto an empty free list
+void ObjectAllocator::refill_free_list(void)
+{
+  // The block maps are the free lists, the lowest free object on the fullest page goes next
+  if (Configuration_.Policy_ == OAConfig::apFullestPage)
+  {
+    char* page = get_fullest_page();
+    if (page == nullptr)
+    {
+      allocate_new_page();
+      page = get_fullest_page();
+    }
+
+    FreeList_ = reinterpret_cast<GenericObject*>(get_object(page, find_free_block(page)));
+    FreeList_->Next = nullptr;
+    return;
+  }
+
+  // Nothing left to carve, so it takes a new page
+  if (CarvePage_ == nullptr)
+    allocate_new_page();
+
+  // A lazy page gives up one object at a time
+  if (FreeList_ == nullptr)
+    carve_object();
+}
+
+// moves the next untouched object onto the free list
+void ObjectAllocator::carve_object(void)
+{
+  GenericObject* node = reinterpret_cast<GenericObject*>(get_object(CarvePage_, CarveNext_));
+
+  // The page didn't set up this block's signatures
+  if (Configuration_.DebugOn_)
+    set_block_bytes(CarvePage_, CarveNext_);
+
+  // Or its side table headers
+  if (SideTable_.Size != 0)
+    clear_side_header(CarvePage_, CarveNext_);
+
+  node->Next = FreeList_;
+  FreeList_ = node;
+
+  // That was the last one
+  if (++CarveNext_ == Configuration_.ObjectsPerPage_)
+    CarvePage_ = nullptr;
+}
+
+// Puts Object onto the free list
+void ObjectAllocator::put_on_freelist(void* Object)
+{
+  // Its page's block map already has it
+  if (Configuration_.Policy_ != OAConfig::apFullestPage)
+  {
+    // Have the object point to the head of the free list
+    reinterpret_cast<GenericObject*>(Object)->Next = FreeList_;
+
+    // Reset the head of the list
+    FreeList_ = reinterpret_cast<GenericObject*>(Object);
+  }
+
+  // Then, adjust stats
+  Statistics_.ObjectsInUse_--;
+  Statistics_.FreeObjects_++;
+  Statistics_.Deallocations_++;
+}
+
+// Puts a chain of objects onto the free list
+void ObjectAllocator::splice_onto_freelist(GenericObject* Head, GenericObject* Tail, unsigned Count)
+{
+  // Nothing to put back
+  if (Head == nullptr)
+    return;
+
+  // The end of the chain points at the old head of the free list, unless the block maps are the list
+  if (Configuration_.Policy_ != OAConfig::apFullestPage)
+  {
+    Tail->Next = FreeList_;
+    FreeList_ = Head;
+  }
+
+  // Then, adjust stats once for the whole chain
+  Statistics_.ObjectsInUse_ -= Count;
+  Statistics_.FreeObjects_ += Count;
+  Statistics_.Deallocations_ += Count;
+  get_telemetry_shard().Deallocations.fetch_add(Count, std::memory_order_relaxed);
+}
+
+bool ObjectAllocator::can_batch(void) const
+{
+#ifdef OA_PROFILING
+  // Every object has to be offered to the profiler
+  if (Configuration_.Profiler_ != nullptr)
+    return false;
+#endif
+
+  // Thread safe modes, the CPP manager and headers all need a full Allocate/Free per object
+  return Configuration_.ThreadCacheSize_ == 0 && !LockFree_ && !Configuration_.UseCPPMemManager_ && !Configuration_.Region_ &&
+         Configuration_.QuarantineSize_ == 0 &&
+         Configuration_.HBlockInfo_.type_ == OAConfig::hbNone;
+}
+
+void ObjectAllocator::check_double_free(char* Page, void* Object)
+{
+  // The block map says whether the client still owns this block
+  if (!is_block_in_use(Page, get_block_index(Page, Object)))
+    throw OAException(OAException::E_MULTIPLE_FREE, "Object has already been freed!");
+}
+
+char* ObjectAllocator::check_within_bounds(void* Object)
+{
+  // This is called with one object that is trying to be freed
+
+  // Find the page the object is on
+  char* page = find_page(Object);
+
+  if (page != nullptr)
+  {
+    // The distance from the first object on the page
+    char* first = get_object(page, 0);
+
+    // It has to land exactly on the start of an object
+    if (reinterpret_cast<char*>(Object) >= first &&
+        !((reinterpret_cast<char*>(Object) - first) % get_size_of_object()))
+      return page;
+  }
+  
+  // The item was never within a single page
+  throw OAException(OAException::E_BAD_BOUNDARY, "Object is not on a page correctly!");
+
+}
+
+void ObjectAllocator::check_corrputed_pad(void* Object)
+{
+  // Check if the bytes on either side have been touched
+  if (is_corrupted(Object))
+    throw OAException(OAException::E_CORRUPTED_BLOCK, "The boundaries of this object were corrupted!");
+}
+
+void ObjectAllocator::set_padding_bytes(char* Page)
+{
+  // Walks through the page
+  char* walker = get_object(Page, 0);
+
+  // While in the list
+  for(unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
+  {
+    // Set pad bytes behind the object
+    memset((walker - Configuration_.PadBytes_), PAD_PATTERN, Configuration_.PadBytes_);
+
+    // Set pad bytes ahead the object
+    memset((walker + Statistics_.ObjectSize_), PAD_PATTERN, Configuration_.PadBytes_);
+
+    // Move to the next object
+    walker += get_size_of_object();
+  }
+
+}
+
+void ObjectAllocator::set_alignment_bytes(char* Page)
+{
+  // The bytes in front of the first block
+  memset(Page + get_size_of_header(), ALIGN_PATTERN, Configuration_.LeftAlignSize_);
+
+  // Walks through the page, starting at the end of the first block
+  char* walker = get_object(Page, 0) + Statistics_.ObjectSize_ + Configuration_.PadBytes_;
+
+  // The bytes between every pair of blocks
+  for (unsigned i = 1; i < Configuration_.ObjectsPerPage_; ++i)
+  {
+    memset(walker, ALIGN_PATTERN, Configuration_.InterAlignSize_);
+
+    // Move to the next object
+    walker += get_size_of_object();
+  }
+}
+
+void ObjectAllocator::set_header_bytes(char* Page)
+{
+  // The headers aren't between the blocks
+  if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable)
+    return;
+
+  // Walks through the page
+  char* walker = get_object(Page, 0);
+  
+  // While in the list
+  for (unsigned i = 0; i < Configuration_.ObjectsPerPage_; ++i)
+  {
+    // If the header is external
+    if(Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+    {
+      // Make a mem block info pointer
+	  reinterpret_cast<GenericObject*>(walker - Configuration_.HBlockInfo_.size_ -
+	                                   Configuration_.PadBytes_)->Next = nullptr;
+    }
+	else
+	{
+      // Set header for the object
+      memset((walker - Configuration_.PadBytes_ - Configuration_.HBlockInfo_.size_), 0,
+	         Configuration_.HBlockInfo_.size_);
+	}
+    
+	// Move to the next object
+	walker += get_size_of_object();
+  }
+}
+
+void ObjectAllocator::set_block_bytes(char* Page, unsigned Index)
+{
+  char* object = get_object(Page, Index);
+
+  // The block itself and its pads
+  memset(object, UNALLOCATED_PATTERN, Statistics_.ObjectSize_);
+  memset(object - Configuration_.PadBytes_, PAD_PATTERN, Configuration_.PadBytes_);
+  memset(object + Statistics_.ObjectSize_, PAD_PATTERN, Configuration_.PadBytes_);
+
+  // Clear the header, same as set_header_bytes (a side table has nothing in front of the block)
+  char* header = object - Configuration_.PadBytes_ - get_inline_header_size();
+  if (Configuration_.HeaderLayout_ == OAConfig::hlInline && Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+    reinterpret_cast<GenericObject*>(header)->Next = nullptr;
+  else
+    memset(header, 0, get_inline_header_size());
+
+  // The last block doesn't have alignment bytes after it
+  if (Index + 1 < Configuration_.ObjectsPerPage_)
+    memset(object + Statistics_.ObjectSize_ + Configuration_.PadBytes_, ALIGN_PATTERN,
+           Configuration_.InterAlignSize_);
+}
+
+void ObjectAllocator::set_header_data(void* Object)
+{
+  // Set the "free" bit
+  bool *freeBit = reinterpret_cast<bool*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
+                                          - sizeof(bool));
+  *freeBit = true;
+
+  // Set the allocation number
+  int *allocations = reinterpret_cast<int*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
+                                            - sizeof(int) - sizeof(bool));
+  *allocations = Statistics_.Allocations_;
+
+  // If it's more than basic
+  if(Configuration_.HBlockInfo_.type_ != OAConfig::hbBasic)
+  {
+	  // Set the counter bits
+	  short *counter = reinterpret_cast<short*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
+	                                            - sizeof(int) - sizeof(bool) - sizeof(short));
+	  ++(*counter);
+
+	  // Clear the user's data
+	  void *userData = reinterpret_cast<bool*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
+	                                           - Configuration_.HBlockInfo_.size_);
+	  memset(userData, 0, (Configuration_.HBlockInfo_.size_ - sizeof(int) - sizeof(bool) - sizeof(short)));
+  }
+
+}
+
+void ObjectAllocator::set_external_header(void* Object, const char* label)
+{
+  // Create the new external header
+  MemBlockInfo *newInfo = new MemBlockInfo(true, label, Statistics_.Allocations_);
+
+  // Point at it
+  intptr_t* pointing = reinterpret_cast<intptr_t*>(reinterpret_cast<char*>(Object) -
+                                                   Configuration_.PadBytes_ -
+												   Configuration_.HBlockInfo_.size_);
+  intptr_t address = reinterpret_cast<intptr_t>(newInfo);
+  *pointing = address;
+}
+
+void ObjectAllocator::free_header_data(void* Object)
+{
+	// If the header is external
+	if(Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+	{
+      // Get the pointer
+	  MemBlockInfo **externalHeader = reinterpret_cast<MemBlockInfo**>(reinterpret_cast<char*>(Object)
+	                                                                   - Configuration_.PadBytes_ -
+																	   Configuration_.HBlockInfo_.size_);
+	  
+	  // Delete this header
+	  delete *externalHeader;
+	  
+	  // Set the value of the pointer in the object to nullptr
+	  *externalHeader = nullptr;
+	}
+	else
+	{
+      // In case the header is Extended
+      short counter = 0;
+      
+      // Save the counter value
+      if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExtended)
+        counter = *reinterpret_cast<short*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
+	                                        - sizeof(int) - sizeof(bool) - sizeof(short));
+      
+      // Clear everything
+      memset((reinterpret_cast<char*>(Object) - Configuration_.PadBytes_ - Configuration_.HBlockInfo_.size_),
+	         0, Configuration_.HBlockInfo_.size_);
+      
+      // If the header was Extended
+      if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExtended)
+      {
+        short *newCounter = reinterpret_cast<short*>(reinterpret_cast<char*>(Object) - Configuration_.PadBytes_
+		                                             - sizeof(int) - sizeof(bool) - sizeof(short));
+        *newCounter = counter;
+      }
+	}
+
+}
+
+void ObjectAllocator::set_side_table(void)
+{
+  SideTable_.AllocNums = SideTable_.Labels = SideTable_.UseCounts = 0;
+  SideTable_.Flags = SideTable_.UserData = SideTable_.Size = 0;
+
+  // Headers stay in front of the blocks, or there aren't any
+  if (Configuration_.HeaderLayout_ != OAConfig::hlSideTable || Configuration_.HBlockInfo_.type_ == OAConfig::hbNone)
+    return;
+
+  size_t count = Configuration_.ObjectsPerPage_;
+  OAConfig::HBLOCK_TYPE type = Configuration_.HBlockInfo_.type_;
+  size_t offset = 0;
+
+  // Biggest entries first so every array lands on its own alignment
+  SideTable_.AllocNums = offset;
+  offset += count * sizeof(unsigned);
+
+  if (type == OAConfig::hbExternal)
+  {
+    SideTable_.Labels = offset;
+    offset += count * sizeof(unsigned);
+  }
+
+  if (type == OAConfig::hbExtended)
+  {
+    SideTable_.UseCounts = offset;
+    offset += count * sizeof(unsigned short);
+  }
+
+  SideTable_.Flags = offset;
+  offset += count;
+
+  if (type == OAConfig::hbExtended)
+  {
+    SideTable_.UserData = offset;
+    offset += count * Configuration_.HBlockInfo_.additional_;
+  }
+
+  // Whatever comes after the table starts on a whole word, same as the block map
+  SideTable_.Size = (offset + sizeof(BlockMapWord) - 1) & ~(sizeof(BlockMapWord) - 1);
+}
+
+size_t ObjectAllocator::get_inline_header_size(void) const
+{
+  // A side table keeps the headers out of the blocks
+  return Configuration_.HeaderLayout_ == OAConfig::hlSideTable ? 0 : Configuration_.HBlockInfo_.size_;
+}
+
+char* ObjectAllocator::get_side_table(const char* Page) const
+{
+  // Right after the block map
+  return const_cast<char*>(Page) + sizeof(void*) + ((get_block_map_words() + 1) * sizeof(BlockMapWord));
+}
+
+unsigned ObjectAllocator::intern_label(const char* Label)
+{
+  // No label
+  if (Label == nullptr)
+    return 0;
+
+  // Every label after the first of its kind is just a lookup
+  std::unordered_map<std::string_view, unsigned>::const_iterator found = LabelIds_.find(std::string_view(Label));
+  if (found != LabelIds_.end())
+    return found->second;
+
+  try
+  {
+    // The deque never moves its strings, so the view in the map stays good
+    Labels_.push_back(Label);
+
+    try
+    {
+      LabelIds_.insert(std::make_pair(std::string_view(Labels_.back()), static_cast<unsigned>(Labels_.size())));
+    }
+    catch (std::bad_alloc&)
+    {
+      Labels_.pop_back();
+      throw;
+    }
+  }
+  catch (std::bad_alloc&)
+  {
+    throw OAException(OAException::E_NO_MEMORY, "Out of memory for external header!");
+  }
+
+  return static_cast<unsigned>(Labels_.size());
+}
+
+void ObjectAllocator::set_side_header(char* Page, void* Object, unsigned LabelId)
+{
+  char* table = get_side_table(Page);
+  unsigned index = get_block_index(Page, Object);
+
+  // Same as set_header_data, one entry in each array instead of bytes in front of the block
+  reinterpret_cast<unsigned*>(table + SideTable_.AllocNums)[index] = Statistics_.Allocations_;
+  table[SideTable_.Flags + index] = 1;
+
+  if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExtended)
+  {
+    ++reinterpret_cast<unsigned short*>(table + SideTable_.UseCounts)[index];
+    memset(table + SideTable_.UserData + (index * Configuration_.HBlockInfo_.additional_), 0,
+           Configuration_.HBlockInfo_.additional_);
+  }
+  // Same as set_external_header, except the label was already copied once for everyone
+  else if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExternal)
+    reinterpret_cast<unsigned*>(table + SideTable_.Labels)[index] = LabelId;
+}
+
+void ObjectAllocator::free_side_header(char* Page, void* Object)
+{
+  unsigned index = get_block_index(Page, Object);
+
+  // Same as free_header_data, the use counter is the only thing that survives
+  if (Configuration_.HBlockInfo_.type_ == OAConfig::hbExtended)
+  {
+    unsigned short* counter = reinterpret_cast<unsigned short*>(get_side_table(Page) + SideTable_.UseCounts) + index;
+    unsigned short count = *counter;
+
+    clear_side_header(Page, index);
+    *counter = count;
+  }
+  else
+    clear_side_header(Page, index);
+}
+
+void ObjectAllocator::clear_side_header(char* Page, unsigned Index)
+{
+  char* table = get_side_table(Page);
+  OAConfig::HBLOCK_TYPE type = Configuration_.HBlockInfo_.type_;
+
+  reinterpret_cast<unsigned*>(table + SideTable_.AllocNums)[Index] = 0;
+  table[SideTable_.Flags + Index] = 0;
+
+  if (type == OAConfig::hbExternal)
+    reinterpret_cast<unsigned*>(table + SideTable_.Labels)[Index] = 0;
+
+  if (type == OAConfig::hbExtended)
+  {
+    reinterpret_cast<unsigned short*>(table + SideTable_.UseCounts)[Index] = 0;
+    memset(table + SideTable_.UserData + (Index * Configuration_.HBlockInfo_.additional_), 0,
+           Configuration_.HBlockInfo_.additional_);
+  }
+}
+
+void ObjectAllocator::move_header(char* FromPage, void* From, char* ToPage, void* To)
+{
+  // The header goes with the object, an external one is just its pointer
+  if (Configuration_.HeaderLayout_ == OAConfig::hlInline)
+  {
+    size_t headerSize = Configuration_.HBlockInfo_.size_;
+    char* fromHeader = static_cast<char*>(From) - Configuration_.PadBytes_ - headerSize;
+    char* toHeader = static_cast<char*>(To) - Configuration_.PadBytes_ - headerSize;
+
+    memcpy(toHeader, fromHeader, headerSize);
+    memset(fromHeader, 0, headerSize);
+    return;
+  }
+
+  // No headers
+  if (SideTable_.Size == 0)
+    return;
+
+  char* fromTable = get_side_table(FromPage);
+  char* toTable = get_side_table(ToPage);
+  unsigned from = get_block_index(FromPage, From);
+  unsigned to = get_block_index(ToPage, To);
+  OAConfig::HBLOCK_TYPE type = Configuration_.HBlockInfo_.type_;
+
+  // One entry out of each array
+  reinterpret_cast<unsigned*>(toTable + SideTable_.AllocNums)[to] =
+    reinterpret_cast<unsigned*>(fromTable + SideTable_.AllocNums)[from];
+  toTable[SideTable_.Flags + to] = fromTable[SideTable_.Flags + from];
+
+  if (type == OAConfig::hbExternal)
+    reinterpret_cast<unsigned*>(toTable + SideTable_.Labels)[to] =
+      reinterpret_cast<unsigned*>(fromTable + SideTable_.Labels)[from];
+
+  if (type == OAConfig::hbExtended)
+  {
+    size_t additional = Configuration_.HBlockInfo_.additional_;
+
+    reinterpret_cast<unsigned short*>(toTable + SideTable_.UseCounts)[to] =
+      reinterpret_cast<unsigned short*>(fromTable + SideTable_.UseCounts)[from];
+    memcpy(toTable + SideTable_.UserData + (to * additional), fromTable + SideTable_.UserData + (from * additional),
+           additional);
+  }
+
+  clear_side_header(FromPage, from);
+}
+
+void* ObjectAllocator::allocate_region(unsigned LabelId)
+{
+  // The current page is used up
+  if (RegionNext_ == Configuration_.ObjectsPerPage_)
+  {
+    ++RegionIndex_;
+    RegionNext_ = 0;
+  }
+
+  // Further than the region has ever gone before
+  if (RegionIndex_ == RegionPages_.size())
+    allocate_new_page();
+
+  char* page = RegionPages_[RegionIndex_];
+
+  // First object on the page since a Reset, whatever the page says is from the last cycle
+  if (RegionNext_ == 0)
+  {
+    *get_live_count(page) = 0;
+    memset(get_block_map(page), 0, get_block_map_words() * sizeof(BlockMapWord));
+  }
+
+  void* object = get_object(page, RegionNext_++);
+
+  // The block map still knows which objects are out, for the debug checks and the walks
+  set_block_state(page, object, true);
+  ++*get_live_count(page);
+
+  // Adjust stats
+  Statistics_.Allocations_++;
+  Statistics_.ObjectsInUse_++;
+  Statistics_.FreeObjects_--;
+  if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
+    Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
+
+  // Add the correct signature
+  if (Configuration_.DebugOn_)
+    memset(object, ALLOCATED_PATTERN, Statistics_.ObjectSize_);
+
+  // External headers always use the side table in a region
+  if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable)
+    set_side_header(page, object, LabelId);
+  else if (Configuration_.HBlockInfo_.type_ != OAConfig::hbNone)
+    set_header_data(object);
+
+  return object;
+}
+
+bool ObjectAllocator::free_region(void* Object)
+{
+  char* page = nullptr;
+
+  // Same checks Free does, handing out since the last Reset is what counts as allocated
+  if (Configuration_.DebugOn_)
+  {
+    page = check_within_bounds(Object);
+    if (get_block_index(page, Object) >= get_carved_count(page))
+      throw OAException(OAException::E_MULTIPLE_FREE, "Object has already been freed!");
+    check_double_free(page, Object);
+    if (Configuration_.PadBytes_ > 0)
+      check_corrputed_pad(Object);
+
+    memset(Object, FREED_PATTERN, Statistics_.ObjectSize_);
+  }
+  else
+  {
+    page = find_page(Object);
+
+    // Not even on one of our pages
+    if (page == nullptr)
+      throw OAException(OAException::E_BAD_BOUNDARY, "Object is not on a page correctly!");
+  }
+
+  // Without the checks a stale object is just ignored, so the counts stay right
+  unsigned index = get_block_index(page, Object);
+  if (index >= get_carved_count(page) || !is_block_in_use(page, index))
+    return false;
+
+  if (Configuration_.HeaderLayout_ == OAConfig::hlSideTable)
+    free_side_header(page, Object);
+  else if (Configuration_.HBlockInfo_.type_ != OAConfig::hbNone)
+    free_header_data(Object);
+
+  // Out of the client's hands, but the block stays used until Reset
+  set_block_state(page, Object, false);
+  --*get_live_count(page);
+  Statistics_.ObjectsInUse_--;
+  Statistics_.Deallocations_++;
+
+  return true;
+}
+
+unsigned ObjectAllocator::free_region_pages(void)
+{
+  // The cursor's page and everything before it may have objects out
+  size_t keep = std::min(RegionIndex_ + 1, RegionPages_.size());
+  if (keep == RegionPages_.size())
+    return 0;
+
+  // Drop the rest out of the index, it stays sorted
+  std::vector<char*>::iterator end = PageIndex_.begin();
+  for (std::vector<char*>::iterator it = PageIndex_.begin(); it != PageIndex_.end(); ++it)
+    if (*get_bin_slot(*it) < keep)
+      *end++ = *it;
+  PageIndex_.erase(end, PageIndex_.end());
+
+  // Unlink and release the pages themselves
+  GenericObject** pageLink = &PageList_;
+  while (*pageLink != nullptr)
+  {
+    GenericObject* page = *pageLink;
+
+    if (*get_bin_slot(reinterpret_cast<char*>(page)) < keep)
+      pageLink = &page->Next;
+    else
+    {
+      *pageLink = page->Next;
+      delete_page(reinterpret_cast<char*>(page));
+    }
+  }
+
+  unsigned freed = static_cast<unsigned>(RegionPages_.size() - keep);
+  RegionPages_.resize(keep);
+
+  // Adjust stats
+  Statistics_.PagesInUse_ -= freed;
+  Statistics_.FreeObjects_ -= freed * Configuration_.ObjectsPerPage_;
+  publish_pages(freed);
+  EmptyPages_ -= std::min(EmptyPages_, freed);
+
+  return freed;
+}
+
+void ObjectAllocator::quarantine_object(char* Page, void* Object)
+{
+  // Out of the client's hands, and a second Free is still caught by the block map
+  set_block_state(Page, Object, false);
+  Statistics_.ObjectsInUse_--;
+  Statistics_.Deallocations_++;
+  record_free(Object);
+
+  // The fill that has to survive until it comes out (debug already has it)
+  if (Configuration_.CheckQuarantine_ && !Configuration_.DebugOn_)
+    memset(Object, FREED_PATTERN, Statistics_.ObjectSize_);
+
+  // Room for one more
+  if (QuarantineCount_ < Quarantine_.size())
+  {
+    Quarantine_[(QuarantineHead_ + QuarantineCount_) % Quarantine_.size()] = Object;
+    ++QuarantineCount_;
+    return;
+  }
+
+  // Full, so the oldest makes room for it
+  void* oldest = Quarantine_[QuarantineHead_];
+  Quarantine_[QuarantineHead_] = Object;
+  QuarantineHead_ = (QuarantineHead_ + 1) % Quarantine_.size();
+
+  bool intact = release_quarantined(oldest);
+
+  // Reported, never thrown, the client only freed Object and it was freed
+  if (!intact)
+    report_use_after_free(oldest);
+}
+
+bool ObjectAllocator::release_quarantined(void* Object)
+{
+  // Checked before the free list link goes in
+  bool intact = !Configuration_.CheckQuarantine_ ||
+                is_filled(static_cast<const unsigned char*>(Object), Statistics_.ObjectSize_, FREED_PATTERN);
+
+  // The block belongs to the allocator again, then the object goes on the list
+  give_to_page(find_page(Object), Object);
+  reinterpret_cast<GenericObject*>(Object)->Next = FreeList_;
+  FreeList_ = reinterpret_cast<GenericObject*>(Object);
+  Statistics_.FreeObjects_++;
+
+  return intact;
+}
+
+void ObjectAllocator::report_use_after_free(void* Object) const
+{
+  if (Configuration_.UseAfterFree_ != nullptr)
+  {
+    Configuration_.UseAfterFree_(Object, Statistics_.ObjectSize_);
+    return;
+  }
+
+  // Nobody asked to be told, so at least leave a trace
+  std::cerr << "ObjectAllocator: freed object " << Object << " (" << Statistics_.ObjectSize_
+            << " bytes) was written to while it was in quarantine" << std::endl;
+}
+
+void* ObjectAllocator::allocate_system(void)
+{
+  size_t offset = get_system_offset();
+  size_t size = SystemDebug_ ? offset + Statistics_.ObjectSize_ + Configuration_.PadBytes_ : Statistics_.ObjectSize_;
+  size_t alignment = get_system_alignment();
+  char* block = nullptr;
+
+  try
+  {
+    block = static_cast<char*>(alignment != 0 ? operator new(size, std::align_val_t(alignment)) : operator new(size));
+  }
+  catch (std::bad_alloc&)
+  {
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+
+  char* object = block + offset;
+
+  // Same signatures a block on a page would have, and remember it for the checks in Free
+  if (SystemDebug_)
+  {
+    try
+    {
+      SystemObjects_.insert(object);
+    }
+    catch (std::bad_alloc&)
+    {
+      release_system_block(block);
+      throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+    }
+
+    memset(block, ALIGN_PATTERN, offset - Configuration_.PadBytes_);
+    memset(object - Configuration_.PadBytes_, PAD_PATTERN, Configuration_.PadBytes_);
+    memset(object, ALLOCATED_PATTERN, Statistics_.ObjectSize_);
+    memset(object + Statistics_.ObjectSize_, PAD_PATTERN, Configuration_.PadBytes_);
+  }
+
+  // Adjust stats, there is never anything free to count
+  Statistics_.Allocations_++;
+  Statistics_.ObjectsInUse_++;
+  if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
+    Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
+
+  return object;
+}
+
+void ObjectAllocator::free_system(void* Object)
+{
+  // Same checks Free does on a page
+  if (SystemDebug_)
+  {
+    // Nothing to tell apart a double free from a pointer that was never ours
+    std::unordered_set<void*>::iterator found = SystemObjects_.find(Object);
+    if (found == SystemObjects_.end())
+      throw OAException(OAException::E_BAD_BOUNDARY, "Object was never allocated or has already been freed!");
+
+    if (is_corrupted(Object))
+      throw OAException(OAException::E_CORRUPTED_BLOCK, "The boundaries of this object were corrupted!");
+
+    memset(Object, FREED_PATTERN, Statistics_.ObjectSize_);
+    SystemObjects_.erase(found);
+  }
+
+  release_system_block(static_cast<char*>(Object) - get_system_offset());
+
+  // Adjust stats
+  Statistics_.ObjectsInUse_--;
+  Statistics_.Deallocations_++;
+}
+
+void ObjectAllocator::release_system_block(char* Block) const
+{
+  // Has to match the new in allocate_system
+  if (get_system_alignment() != 0)
+    operator delete(Block, std::align_val_t(get_system_alignment()));
+  else
+    operator delete(Block);
+}
+
+size_t ObjectAllocator::get_system_offset(void) const
+{
+  // Just the object without the debug checks
+  if (!SystemDebug_)
+    return 0;
+
+  // The left pad, pushed out so the object still lands on the alignment
+  size_t offset = Configuration_.PadBytes_;
+  if (Configuration_.Alignment_ > 1)
+    offset = (offset + Configuration_.Alignment_ - 1) / Configuration_.Alignment_ * Configuration_.Alignment_;
+
+  return offset;
+}
+
+size_t ObjectAllocator::get_system_alignment(void) const
+{
+  // The plain operator new is already aligned enough
+  return Configuration_.Alignment_ > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? Configuration_.Alignment_ : 0;
+}
+
+void ObjectAllocator::get_system_objects(std::vector<void*>& Objects) const
+{
+  std::unique_lock<std::mutex> depot(DepotLock_, std::defer_lock);
+  if (Configuration_.ThreadCacheSize_ > 0)
+    depot.lock();
+
+  // In address order, same as walking the pages
+  Objects.assign(SystemObjects_.begin(), SystemObjects_.end());
+  std::sort(Objects.begin(), Objects.end());
+}
+
+size_t ObjectAllocator::get_size_of_header() const
+{
+  // The next page pointer, the live count, the block map, then any side table headers
+  return sizeof(void*) + ((get_block_map_words() + 1) * sizeof(BlockMapWord)) + SideTable_.Size;
+}
+
+size_t ObjectAllocator::get_size_of_object() const
+{
+  // This will cover the full distance of one object, up to the start of the next
+  return Statistics_.ObjectSize_ + (Configuration_.PadBytes_ * 2) + get_inline_header_size() +
+         Configuration_.InterAlignSize_;
+}
+
+size_t ObjectAllocator::get_page_alignment() const
+{
+  // At least what the header words need
+  size_t alignment = sizeof(BlockMapWord);
+
+  // Objects are only aligned relative to the page, so the page has to be aligned as well
+  while (alignment < Configuration_.Alignment_)
+    alignment <<= 1;
+
+  return alignment;
+}
+
+void ObjectAllocator::delete_page(char* Page)
+{
+  // Back to wherever allocate_new_page got it
+  Configuration_.PageSource_->ReleasePage(Page, Statistics_.PageSize_, get_page_alignment());
+}
+
+unsigned ObjectAllocator::get_carved_count(const char* Page) const
+{
+  // Pages before the region's cursor are full, pages after it haven't been used since the last Reset
+  if (Configuration_.Region_)
+  {
+    size_t position = *get_bin_slot(Page);
+    if (position != RegionIndex_)
+      return position < RegionIndex_ ? Configuration_.ObjectsPerPage_ : 0;
+
+    return RegionNext_;
+  }
+
+  // Only the newest lazy page can have objects nobody has touched
+  return Page == CarvePage_ ? CarveNext_ : Configuration_.ObjectsPerPage_;
+}
+
+size_t ObjectAllocator::get_block_map_words() const
+{
+  // Enough words to hold one bit for every object on a page
+  return (Configuration_.ObjectsPerPage_ + BLOCKS_PER_WORD - 1) / BLOCKS_PER_WORD;
+}
+
+unsigned* ObjectAllocator::get_live_count(const char* Page) const
+{
+  // The live count sits right after the next page pointer
+  return reinterpret_cast<unsigned*>(const_cast<char*>(Page) + sizeof(void*));
+}
+
+ObjectAllocator::BlockMapWord* ObjectAllocator::get_block_map(const char* Page) const
+{
+  // The block map follows the live count, which gets a whole word to keep the map aligned
+  return reinterpret_cast<BlockMapWord*>(const_cast<char*>(Page) + sizeof(void*) + sizeof(BlockMapWord));
+}
+
+char* ObjectAllocator::get_object(const char* Page, unsigned Index) const
+{
+  // Skip the page header and alignment, then the block's header and left padding
+  return const_cast<char*>(Page) + get_size_of_header() + Configuration_.LeftAlignSize_ +
+         (get_size_of_object() * Index) + get_inline_header_size() + Configuration_.PadBytes_;
+}
+
+unsigned ObjectAllocator::get_block_index(const char* Page, const void* Object) const
+{
+  // How many objects in from the start of the page
+  return static_cast<unsigned>((reinterpret_cast<const char*>(Object) - get_object(Page, 0)) /
+                               get_size_of_object());
+}
+
+char* ObjectAllocator::find_page(const void* Object) const
+{
+  // A search rather than masking the address, which would need pages aligned to their size rounded up
+  // to a power of two. That costs up to a page of address space per page, and most of a page of
+  // wasted heap per page from the default HeapPageSource.
+  const char* address = reinterpret_cast<const char*>(Object);
+
+  // The first page that starts after the address
+  std::vector<char*>::const_iterator next = std::upper_bound(PageIndex_.begin(), PageIndex_.end(), address);
+
+  // The address is before every page
+  if (next == PageIndex_.begin())
+    return nullptr;
+
+  // The only page that could hold it is the one before that
+  char* page = *(next - 1);
+
+  // If the address is somewhere on this page
+  if (address > page && address < page + Statistics_.PageSize_)
+    return page;
+
+  // Not one of ours
+  return nullptr;
+}
+
+void ObjectAllocator::add_to_page_index(char* Page)
+{
+  // Keep the index sorted so lookups can binary search it
+  PageIndex_.insert(std::upper_bound(PageIndex_.begin(), PageIndex_.end(), Page), Page);
+}
+
+void ObjectAllocator::set_block_state(char* Page, void* Object, bool InUse)
+{
+  // Find the bit for this object
+  unsigned index = get_block_index(Page, Object);
+  BlockMapWord bit = BlockMapWord(1) << (index % BLOCKS_PER_WORD);
+
+  if (InUse)
+    get_block_map(Page)[index / BLOCKS_PER_WORD] |= bit;
+  else
+    get_block_map(Page)[index / BLOCKS_PER_WORD] &= ~bit;
+}
+
+bool ObjectAllocator::is_block_in_use(const char* Page, unsigned Index) const
+{
+  // Check the bit for this slot
+  return (get_block_map(Page)[Index / BLOCKS_PER_WORD] >> (Index % BLOCKS_PER_WORD)) & 1;
+}
+
+void ObjectAllocator::take_from_page(char* Page, void* Object)
+{
+  unsigned live = (*get_live_count(Page))++;
+
+  // The page is no longer empty
+  if (live == 0)
+    --EmptyPages_;
+
+  set_block_state(Page, Object, true);
+
+  // It might be full enough for the next bin up
+  if (Configuration_.Policy_ == OAConfig::apFullestPage)
+    move_page_bin(Page, live);
+}
+
+void ObjectAllocator::give_to_page(char* Page, void* Object)
+{
+  unsigned live = (*get_live_count(Page))--;
+
+  // The page just became empty
+  if (live == 1)
+    ++EmptyPages_;
+
+  set_block_state(Page, Object, false);
+
+  // It might belong in a lower bin now
+  if (Configuration_.Policy_ == OAConfig::apFullestPage)
+    move_page_bin(Page, live);
+}
+
+int ObjectAllocator::get_page_bin(unsigned LiveCount) const
+{
+  // Full pages have nothing to hand out
+  if (LiveCount == Configuration_.ObjectsPerPage_)
+    return -1;
+
+  // Empty pages go last, so FreeEmptyPages can have them
+  if (LiveCount == 0)
+    return 0;
+
+  return 1 + static_cast<int>((LiveCount - 1) * PARTIAL_BINS / Configuration_.ObjectsPerPage_);
+}
+
+void ObjectAllocator::move_page_bin(char* Page, unsigned OldCount)
+{
+  int oldBin = get_page_bin(OldCount);
+  int newBin = get_page_bin(*get_live_count(Page));
+
+  // Most changes stay in the same bin
+  if (oldBin == newBin)
+    return;
+
+  if (oldBin >= 0)
+    remove_from_page_bin(Page, oldBin);
+  if (newBin >= 0)
+    add_to_page_bin(Page, newBin);
+}
+
+void ObjectAllocator::add_to_page_bin(char* Page, int Bin)
+{
+  // There is already room, allocate_new_page made it
+  *get_bin_slot(Page) = static_cast<unsigned>(PageBins_[Bin].size());
+  PageBins_[Bin].push_back(Page);
+}
+
+void ObjectAllocator::remove_from_page_bin(char* Page, int Bin)
+{
+  // Fill the hole with the last page in the bin
+  unsigned slot = *get_bin_slot(Page);
+  char* last = PageBins_[Bin].back();
+
+  PageBins_[Bin][slot] = last;
+  *get_bin_slot(last) = slot;
+  PageBins_[Bin].pop_back();
+}
+
+char* ObjectAllocator::get_fullest_page(void) const
+{
+  // Fullest bin first, any page in it will do
+  for (unsigned i = PARTIAL_BINS + 1; i > 0; --i)
+    if (!PageBins_[i - 1].empty())
+      return PageBins_[i - 1].back();
+
+  return nullptr;
+}
+
+unsigned* ObjectAllocator::get_bin_slot(const char* Page) const
+{
+  // Shares the live count's word
+  return get_live_count(Page) + 1;
+}
+
+unsigned ObjectAllocator::find_free_block(const char* Page) const
+{
+  const BlockMapWord* map = get_block_map(Page);
+
+  // Skip over the words that are all in use, then take the lowest clear bit
+  for (size_t i = 0; i < get_block_map_words(); ++i)
+    if (~map[i] != 0)
+      return static_cast<unsigned>(i * BLOCKS_PER_WORD) + lowest_set_bit(~map[i]);
+
+  return Configuration_.ObjectsPerPage_;
+}
+
+float ObjectAllocator::get_fragmentation(const OAStats& Stats) const
+{
+  unsigned capacity = Stats.PagesInUse_ * Configuration_.ObjectsPerPage_;
+
+  // The lock-free list doesn't keep track of which pages are empty
+  if (capacity == 0 || LockFree_)
+    return 0.0f;
+
+  // A region can't reuse what was freed until the next Reset
+  if (Configuration_.Region_)
+    return static_cast<float>(capacity - Stats.ObjectsInUse_ - Stats.FreeObjects_) / capacity;
+
+  // Objects on empty pages can be given back, the rest are holes between objects still in use
+  unsigned reclaimable = std::min(EmptyPages_ * Configuration_.ObjectsPerPage_, Stats.FreeObjects_);
+
+  return static_cast<float>(Stats.FreeObjects_ - reclaimable) / capacity;
+}
+
+bool ObjectAllocator::should_free_empty_pages(void) const
+{
+  // Turned off, or there is nothing that could be freed
+  if (Configuration_.EmptyPageThreshold_ <= 0.0f || EmptyPages_ == 0)
+    return false;
+
+  // Too much of the capacity is sitting on the free list
+  return Statistics_.FreeObjects_ >
+         Configuration_.EmptyPageThreshold_ * Statistics_.PagesInUse_ * Configuration_.ObjectsPerPage_;
+}
+
+void ObjectAllocator::update_thread_cache_state(void)
+{
+  // Debug checks, headers and the CPP manager all need the shared lock
+  UseThreadCache_.store(Configuration_.ThreadCacheSize_ > 0 && !Configuration_.DebugOn_ &&
+                        !Configuration_.UseCPPMemManager_ && !Configuration_.Region_ && Configuration_.QuarantineSize_ == 0 &&
+                        Configuration_.HBlockInfo_.type_ == OAConfig::hbNone, std::memory_order_relaxed);
+}
+
+void* ObjectAllocator::allocate_cached(void)
+{
+  Magazine* cache = get_magazine();
+  std::lock_guard<std::mutex> guard(cache->Lock);
+
+  // Only touch the shared free list when the magazine runs dry
+  if (cache->Objects == nullptr)
+    refill_magazine(cache);
+
+  // Take the first object in the magazine
+  GenericObject* object = cache->Objects;
+  cache->Objects = object->Next;
+  object->Next = nullptr;
+
+  // Adjust stats
+  --cache->Count;
+  ++cache->Allocations;
+
+  return object;
+}
+
+void ObjectAllocator::free_cached(void* Object)
+{
+  Magazine* cache = get_magazine();
+  std::lock_guard<std::mutex> guard(cache->Lock);
+
+  // Put it at the front of the magazine
+  reinterpret_cast<GenericObject*>(Object)->Next = cache->Objects;
+  cache->Objects = reinterpret_cast<GenericObject*>(Object);
+
+  // Adjust stats
+  ++cache->Count;
+  ++cache->Deallocations;
+
+  // Give half of it back once it overflows
+  if (cache->Count > Configuration_.ThreadCacheSize_)
+    drain_magazine(cache, cache->Count - (Configuration_.ThreadCacheSize_ / 2));
+}
+
+ObjectAllocator::Magazine* ObjectAllocator::get_magazine(void)
+{
+  // The common case, this thread already has one
+  Magazine* cache = ThreadCaches.find(Id_);
+  if (cache != nullptr)
+    return cache;
+
+  try
+  {
+    std::lock_guard<std::mutex> depot(DepotLock_);
+
+    // Reuse a magazine left behind by a thread that exited
+    for (size_t i = 0; i < Magazines_.size() && cache == nullptr; ++i)
+      if (!Magazines_[i]->Owned)
+        cache = Magazines_[i];
+
+    // Otherwise make a new one
+    if (cache == nullptr)
+    {
+      cache = new Magazine;
+      Magazines_.push_back(cache);
+    }
+
+    cache->Owned = true;
+  }
+  catch (std::bad_alloc&)
+  {
+    delete cache;
+    throw OAException(OAException::E_NO_MEMORY, "Out of memory for thread cache!");
+  }
+
+  // Remember it for next time (outside the depot lock, thread exit takes them the other way around)
+  try
+  {
+    ThreadCaches.add(Id_, cache);
+  }
+  catch (std::bad_alloc&)
+  {
+    release_magazine(cache);
+    throw OAException(OAException::E_NO_MEMORY, "Out of memory for thread cache!");
+  }
+
+  return cache;
+}
+
+void ObjectAllocator::refill_magazine(Magazine* Cache)
+{
+  std::lock_guard<std::mutex> depot(DepotLock_);
+
+  // Fill it half way, so the next few frees don't have to drain it again
+  unsigned batch = std::max(Configuration_.ThreadCacheSize_ / 2, 1u);
+
+  while (Cache->Count < batch)
+  {
+    // Only grow when there is nothing to hand out at all
+    if (FreeList_ == nullptr)
+    {
+      if (Cache->Count != 0 && Statistics_.FreeObjects_ == 0)
+        break;
+
+      refill_free_list();
+    }
+
+    // Move the first free object over
+    GenericObject* object = FreeList_;
+    FreeList_ = object->Next;
+    take_from_page(find_page(object), object);
+
+    object->Next = Cache->Objects;
+    Cache->Objects = object;
+    ++Cache->Count;
+
+    // The shared stats count cached objects as in use
+    Statistics_.FreeObjects_--;
+    Statistics_.ObjectsInUse_++;
+  }
+
+  if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
+    Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
+}
+
+void ObjectAllocator::drain_magazine(Magazine* Cache, unsigned Count)
+{
+  std::lock_guard<std::mutex> depot(DepotLock_);
+
+  for (unsigned i = 0; i < Count && Cache->Objects != nullptr; ++i)
+  {
+    // Take the first object out of the magazine
+    GenericObject* object = Cache->Objects;
+    Cache->Objects = object->Next;
+    --Cache->Count;
+
+    // Frees on the fast path aren't checked, so a stray pointer is dropped here
+    char* page = find_page(object);
+    if (page == nullptr)
+      continue;
+
+    // Put it back on the shared free list
+    give_to_page(page, object);
+    if (Configuration_.Policy_ != OAConfig::apFullestPage)
+    {
+      object->Next = FreeList_;
+      FreeList_ = object;
+    }
+
+    Statistics_.FreeObjects_++;
+    Statistics_.ObjectsInUse_--;
+  }
+
+  // Give memory back if too much of it is sitting idle
+  if (should_free_empty_pages())
+    free_empty_pages();
+}
+
+void ObjectAllocator::release_magazine(Magazine* Cache)
+{
+  {
+    std::lock_guard<std::mutex> guard(Cache->Lock);
+    drain_magazine(Cache, Cache->Count);
+  }
+
+  // Another thread can pick it up now
+  std::lock_guard<std::mutex> depot(DepotLock_);
+  Cache->Owned = false;
+}
+
+void* ObjectAllocator::allocate_lock_free(void)
+{
+  std::uint64_t head = LockFreeHead_.load(std::memory_order_acquire);
+
+  for (;;)
+  {
+    GenericObject* object = unpack_head(head);
+
+    // Out of objects, this is the only time the lock is taken
+    if (object == nullptr)
+    {
+      std::lock_guard<std::mutex> depot(DepotLock_);
+
+      // Another thread may have grown it while we waited
+      if (unpack_head(LockFreeHead_.load(std::memory_order_acquire)) == nullptr)
+      {
+        allocate_new_page();
+        publish_free_list();
+      }
+
+      head = LockFreeHead_.load(std::memory_order_acquire);
+      continue;
+    }
+
+    // If another thread took this object first, Next may be garbage, but then the tag has moved on
+    GenericObject* next = object->Next;
+    if (LockFreeHead_.compare_exchange_weak(head, pack_head(next, head), std::memory_order_acquire,
+                                            std::memory_order_acquire))
+    {
+      object->Next = nullptr;
+      LockFreeAllocations_.fetch_add(1, std::memory_order_relaxed);
+
+      // Add the correct signature
+      if (Configuration_.DebugOn_)
+        memset(object, ALLOCATED_PATTERN, Statistics_.ObjectSize_);
+
+      return object;
+    }
+  }
+}
+
+void ObjectAllocator::free_lock_free(void* Object)
+{
+  // The block maps aren't kept, so a double free can't be caught here
+  if (Configuration_.DebugOn_)
+  {
+    {
+      std::lock_guard<std::mutex> depot(DepotLock_);
+      check_within_bounds(Object);
+    }
+
+    if (Configuration_.PadBytes_ > 0)
+      check_corrputed_pad(Object);
+
+    // Add the correct signatures
+    memset(Object, FREED_PATTERN, Statistics_.ObjectSize_);
+  }
+
+  GenericObject* object = reinterpret_cast<GenericObject*>(Object);
+  std::uint64_t head = LockFreeHead_.load(std::memory_order_relaxed);
+
+  // Put it on top of whatever the head is right now
+  do
+  {
+    object->Next = unpack_head(head);
+  }
+  while (!LockFreeHead_.compare_exchange_weak(head, pack_head(object, head), std::memory_order_release,
+                                              std::memory_order_relaxed));
+
+  LockFreeDeallocations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ObjectAllocator::publish_free_list(void)
+{
+  // Nothing new
+  if (FreeList_ == nullptr)
+    return;
+
+  // Find the end of the chain
+  GenericObject* tail = FreeList_;
+  while (tail->Next != nullptr)
+    tail = tail->Next;
+
+  std::uint64_t head = LockFreeHead_.load(std::memory_order_relaxed);
+
+  // Splice the whole chain on top in one go
+  do
+  {
+    tail->Next = unpack_head(head);
+  }
+  while (!LockFreeHead_.compare_exchange_weak(head, pack_head(FreeList_, head), std::memory_order_release,
+                                              std::memory_order_relaxed));
+
+  FreeList_ = nullptr;
+}
+
+void ObjectAllocator::record_free(void *Object)
+{
+  get_telemetry_shard().Deallocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef OA_PROFILING
+  // Only once the object is released, so a bad pointer that throws is never recorded
+  if (Configuration_.Profiler_ != nullptr)
+    Configuration_.Profiler_->RecordFree(Object);
+#else
+  (void)Object;
+#endif
+}
+
+ObjectAllocator::TelemetryShard &ObjectAllocator::get_telemetry_shard(void)
+{
+  // First allocation or free on this thread
+  if (TelemetryShardIndex == ~0u)
+    TelemetryShardIndex = NextTelemetryShard.fetch_add(1, std::memory_order_relaxed) % TELEMETRY_SHARDS;
+
+  return TelemetryShards_[TelemetryShardIndex];
+}
+
+void ObjectAllocator::publish_pages(unsigned Freed)
+{
+  // Only ever called by whoever is changing the page count, so the peak can't race with itself
+  TelemetryPages_.store(Statistics_.PagesInUse_, std::memory_order_relaxed);
+  if (Statistics_.PagesInUse_ > TelemetryMostPages_.load(std::memory_order_relaxed))
+    TelemetryMostPages_.store(Statistics_.PagesInUse_, std::memory_order_relaxed);
+  if (Freed != 0)
+    TelemetryPagesFreed_.fetch_add(Freed, std::memory_order_relaxed);
+}
+
+std::uint64_t ObjectAllocator::pack_head(GenericObject* Object, std::uint64_t OldHead)
+{
+  // Every change bumps the tag, so a head that was popped and pushed back still looks different
+  std::uint64_t tag = (OldHead >> HEAD_TAG_SHIFT) + 1;
+
+  return (static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(Object)) & HEAD_POINTER_MASK) |
+         (tag << HEAD_TAG_SHIFT);
+}
+
+GenericObject* ObjectAllocator::unpack_head(std::uint64_t Head)
+{
+  return reinterpret_cast<GenericObject*>(static_cast<std::uintptr_t>(Head & HEAD_POINTER_MASK));
+}
+
+void ObjectAllocator::lock_magazines(std::vector<Magazine*>& Caches,
+                                     std::vector<std::unique_lock<std::mutex> >& Locks) const
+{
+  // Magazines are only ever added, so a copy of the list is enough
+  {
+    std::lock_guard<std::mutex> depot(DepotLock_);
+    Caches = Magazines_;
+  }
+
+  // Always in the same order, and always before the depot lock
+  for (size_t i = 0; i < Caches.size(); ++i)
+    Locks.push_back(std::unique_lock<std::mutex>(Caches[i]->Lock));
+}
+
+bool ObjectAllocator::is_corrupted(void* Object) const
+{
+	// This will check the first padding
+	const unsigned char *leftPad = reinterpret_cast<unsigned char*>(reinterpret_cast<char*>(Object)
+	                                                                - Configuration_.PadBytes_);
+	// This will check the second padding
+	const unsigned char *rightPad = reinterpret_cast<unsigned char*>(reinterpret_cast<char*>(Object)
+	                                                                 + Statistics_.ObjectSize_);
+
+	// Check if the bytes have been touched
+	return !is_filled(leftPad, Configuration_.PadBytes_, PAD_PATTERN) ||
+	       !is_filled(rightPad, Configuration_.PadBytes_, PAD_PATTERN);
+}
+
+bool ObjectAllocator::is_freed_overwritten(const char* Page, unsigned Index) const
+{
+  // Only debug fills free objects, and the block maps say which ones are free
+  if (!Configuration_.ValidateFreed_ || !Configuration_.DebugOn_ || LockFree_ || is_block_in_use(Page, Index))
+    return false;
+
+  // The free list link is allowed to be there
+  size_t link = sizeof(GenericObject);
+  if (Statistics_.ObjectSize_ <= link)
+    return false;
+
+  const unsigned char* body = reinterpret_cast<const unsigned char*>(get_object(Page, Index)) + link;
+
+  // Objects that were never handed out still have their first fill
+  unsigned char pattern = body[0] == UNALLOCATED_PATTERN ? UNALLOCATED_PATTERN : FREED_PATTERN;
+
+  return !is_filled(body, Statistics_.ObjectSize_ - link, pattern);
+}
+
+void ObjectAllocator::validate_page(const char* Page, std::vector<void*>& Corrupted) const
+{
+  // Same checks as ValidatePages, but saved for later
+  unsigned carved = get_carved_count(Page);
+  for (unsigned i = 0; i < carved; ++i)
+  {
+    void* object = get_object(Page, i);
+
+    if (is_corrupted(object) || is_freed_overwritten(Page, i))
+      Corrupted.push_back(object);
+  }
+}
+
@@ -1,218 +1,533 @@
-/*!*************************************************************************************************
-\file    ObjectAllocator.h
-\author  Seth Glaser
-\date    1/11/2017
-\par     Class: CS280-A
-\par     Email: seth.g\@digipen.edu
-\brief   This file holds the public interface for the ObjectAllocator.
-***************************************************************************************************/
-
-//--------------------------------------------------------------------------------------------------
-#ifndef OBJECTALLOCATORH
-#define OBJECTALLOCATORH
-//--------------------------------------------------------------------------------------------------
-
-#include <string>
-#include <iostream>
-
-// If the client doesn't specify these:
-static const int DEFAULT_OBJECTS_PER_PAGE = 4;  
-static const int DEFAULT_MAX_PAGES = 3;
-
-class OAException
-{
-  public:
-  
-    enum OA_EXCEPTION 
-		{
-			E_NO_MEMORY,      // out of physical memory (operator new fails)
-			E_NO_PAGES,       // out of logical memory (max pages has been reached)
-			E_BAD_BOUNDARY,   // block address is on a page, but not on any block-boundary
-			E_MULTIPLE_FREE,  // block has already been freed
-			E_CORRUPTED_BLOCK // block has been corrupted (pad bytes have been overwritten)
-		};
-
-    OAException(OA_EXCEPTION ErrCode, const std::string& Message) : error_code_(ErrCode), message_(Message) {};
-
-    virtual ~OAException() {
-    }
-
-    OA_EXCEPTION code(void) const { 
-      return error_code_; 
-    }
-
-    virtual const char *what(void) const {
-      return message_.c_str();
-    }
-  private:  
-    OA_EXCEPTION error_code_;
-    std::string message_;
-	
-};
-
-// ObjectAllocator configuration parameters
-struct OAConfig
-{
-	static const size_t BASIC_HEADER_SIZE = sizeof(unsigned) + 1; // allocation number + flags
-	static const size_t EXTERNAL_HEADER_SIZE = sizeof(void*);     // just a pointer
-
-	enum HBLOCK_TYPE{hbNone, hbBasic, hbExtended, hbExternal};
-	struct HeaderBlockInfo
-	{
-		HBLOCK_TYPE type_;
-		size_t size_;
-		size_t additional_;
-		HeaderBlockInfo(HBLOCK_TYPE type = hbNone, unsigned additional = 0) : type_(type), size_(0), additional_(additional)
-		{
-			if (type_ == hbBasic)
-				size_ = BASIC_HEADER_SIZE;
-			else if (type_ == hbExtended) // alloc # + use counter + flag byte + user-defined
-				size_ = sizeof(unsigned int) + sizeof(unsigned short) + sizeof(char) + additional_;
-			else if (type_ == hbExternal)
-				size_ = EXTERNAL_HEADER_SIZE;
-		};
-	};
-
-	OAConfig(bool UseCPPMemManager = false,
-					 unsigned ObjectsPerPage = DEFAULT_OBJECTS_PER_PAGE, 
-		       unsigned MaxPages = DEFAULT_MAX_PAGES, 
-					 bool DebugOn = false, 
-					 unsigned PadBytes = 0,
-					 const HeaderBlockInfo &HBInfo = HeaderBlockInfo(),
-					 unsigned Alignment = 0) : UseCPPMemManager_(UseCPPMemManager),
-											   ObjectsPerPage_(ObjectsPerPage), 
-											   MaxPages_(MaxPages), 
-					                           DebugOn_(DebugOn), 
-											   PadBytes_(PadBytes),
-											   HBlockInfo_(HBInfo),
-											   Alignment_(Alignment)
-	{
-		HBlockInfo_ = HBInfo;
-		LeftAlignSize_ = 0;  
-		InterAlignSize_ = 0;
-	}
-
-	bool UseCPPMemManager_;       // by-pass the functionality of the OA and use new/delete
-  unsigned ObjectsPerPage_;       // number of objects on each page
-  unsigned MaxPages_;             // maximum number of pages the OA can allocate (0=unlimited)
-	bool DebugOn_;                // enable/disable debugging code (signatures, checks, etc.)
-	unsigned PadBytes_;           // size of the left/right padding for each block
-	HeaderBlockInfo HBlockInfo_;  // size of the header for each block (0=no headers)
-	unsigned Alignment_;          // address alignment of each block
-
-	unsigned LeftAlignSize_;      // number of alignment bytes required to align first block
-	unsigned InterAlignSize_;     // number of alignment bytes required between remaining blocks
-	
-};
-
-// ObjectAllocator statistical info
-struct OAStats
-{
-	OAStats(void) : ObjectSize_(0), PageSize_(0), FreeObjects_(0), ObjectsInUse_(0), PagesInUse_(0),
-                  MostObjects_(0), Allocations_(0), Deallocations_(0) {};
-
-	size_t ObjectSize_;       // size of each object
-	size_t PageSize_;         // size of a page including all headers, padding, etc.
-	unsigned FreeObjects_;    // number of objects on the free list
-	unsigned ObjectsInUse_;   // number of objects in use by client
-	unsigned PagesInUse_;     // number of pages allocated
-	unsigned MostObjects_;    // most objects in use by client at one time
-	unsigned Allocations_;    // total requests to allocate memory
-	unsigned Deallocations_;  // total requests to free memory
-};
-
-// This allows us to easily treat raw objects as nodes in a linked list
-struct GenericObject
-{
-  GenericObject *Next;
-};
-
-struct MemBlockInfo
-{
-	MemBlockInfo(bool inUse, const char* userLabel, unsigned allocNumber);
-	~MemBlockInfo();
-	bool in_use;         // Is the block free or in use?
-	char *label;         // A dynamically allocated NUL-terminated string
-	unsigned alloc_num;  // The allocation number (count) of this block
-};
-
-// This memory manager class 
-class ObjectAllocator
-{
-  public:
-  
-  	// Defined by the client (pointer to a block, size of block)
-	typedef void (*DUMPCALLBACK)(const void *, size_t);
-	typedef void (*VALIDATECALLBACK)(const void *, size_t);
-
-	// Predefined values for memory signatures
-	static const unsigned char UNALLOCATED_PATTERN = 0xAA;
-	static const unsigned char ALLOCATED_PATTERN = 0xBB;
-	static const unsigned char FREED_PATTERN = 0xCC;
-	static const unsigned char PAD_PATTERN = 0xDD;
-	static const unsigned char ALIGN_PATTERN = 0xEE;
-
-    // Creates the ObjectManager per the specified values
-    // Throws an exception if the construction fails. (Memory allocation problem)
-    ObjectAllocator(size_t ObjectSize, const OAConfig& config);
-
-    // Destroys the ObjectManager (never throws)
-    ~ObjectAllocator();
-
-    // Take an object from the free list and give it to the client (simulates new)
-    // Throws an exception if the object can't be allocated. (Memory allocation problem)
-    void *Allocate(const char *label = 0);
-
-    // Returns an object to the free list for the client (simulates delete)
-    // Throws an exception if the the object can't be freed. (Invalid object)
-    void Free(void *Object);
-
-    // Calls the callback fn for each block still in use
-    unsigned DumpMemoryInUse(DUMPCALLBACK fn) const;
-
-    // Calls the callback fn for each block that is potentially corrupted
-	unsigned ValidatePages(VALIDATECALLBACK fn) const;
-
-	// Frees all empty pages (extra credit)
-	unsigned FreeEmptyPages(void);
-
-	// Returns true if FreeEmptyPages and alignments are implemented
-	static bool ImplementedExtraCredit(void);
-
-    // Testing/Debugging/Statistic methods
-    void SetDebugState(bool State);           // true=enable, false=disable
-    const void *GetFreeList(void) const;      // returns a pointer to the internal free list
-    const void *GetPageList(void) const;      // returns a pointer to the internal page list
-		OAConfig GetConfig(void) const;       // returns the configuration parameters
-		OAStats GetStats(void) const;         // returns the statistics for the allocator
-
-  private:
-  
-    GenericObject *PageList_;           // the beginning of the list of pages
-    GenericObject *FreeList_;           // the beginning of the list of objects
-	OAConfig Configuration_;            // the configuration for the allocator
-	OAStats Statistics_;                // the stats for the allocator
-
-    void allocate_new_page(void);                               // allocates another page of objects
-	void allocate_objects(char *page);                          // allocates the objects on the new page
-    void put_on_freelist(void *Object);                         // puts Object onto the free list
-	void check_double_free(void *Object);                       // checks if a freeing object has already been freed
-	void check_within_bounds(void* Object);                     // checks if a passed pointer is within the bounds
-	void check_corrputed_pad(void* Object);                     // checks if the pads on the sides of an object have been touched
-	void set_padding_bytes(char* Page);                         // goes to the correct bytes and places pad byte signatures
-	void set_header_bytes(char* Page);                          // goes to the correct bytes and clears the data
-	void set_header_data(void* Object);                         // Sets the correct data inside of a header when allocated
-	void set_external_header(void* Object, const char* label);  // Allocates and sets up an external header
-	void free_header_data(void* Object);                        // frees the appropriate data in the header
-	size_t get_size_of_header();                                // gets the size of the beginning portion of a page
-	size_t get_size_of_object() const;                          // gets the size of a full object
-	bool is_on_free_list(void* Object) const;                   // checks if an object is on the free list
-	bool is_corrupted(void* Object) const;                      // checks if an object has corrupted pad bytes
-
-      // Make private to prevent copy construction and assignment
-    ObjectAllocator(const ObjectAllocator &oa);
-    ObjectAllocator &operator=(const ObjectAllocator &oa);
-	
-};
-
-#endif
+/*!*************************************************************************************************
+\file    ObjectAllocator.h
+\author  Seth Glaser
+\date    1/11/2017
+\par     Class: CS280-A
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the public interface for the ObjectAllocator.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef OBJECTALLOCATORH
+#define OBJECTALLOCATORH
+//--------------------------------------------------------------------------------------------------
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include "PageSource.h"
+
+class AllocationProfiler;
+
+// If the client doesn't specify these:
+static const int DEFAULT_OBJECTS_PER_PAGE = 4;  
+static const int DEFAULT_MAX_PAGES = 3;
+
+class OAException
+{
+  public:
+  
+    enum OA_EXCEPTION 
+		{
+			E_NO_MEMORY,      // out of physical memory (operator new fails)
+			E_NO_PAGES,       // out of logical memory (max pages has been reached)
+			E_BAD_BOUNDARY,   // block address is on a page, but not on any block-boundary
+			E_MULTIPLE_FREE,  // block has already been freed
+			E_CORRUPTED_BLOCK // block has been corrupted (pad bytes have been overwritten)
+		};
+
+    OAException(OA_EXCEPTION ErrCode, const std::string& Message) : error_code_(ErrCode), message_(Message) {};
+
+    virtual ~OAException() {
+    }
+
+    OA_EXCEPTION code(void) const { 
+      return error_code_; 
+    }
+
+    virtual const char *what(void) const {
+      return message_.c_str();
+    }
+  private:  
+    OA_EXCEPTION error_code_;
+    std::string message_;
+	
+};
+
+// ObjectAllocator configuration parameters
+struct OAConfig
+{
+	static const size_t BASIC_HEADER_SIZE = sizeof(unsigned) + 1; // allocation number + flags
+	static const size_t EXTERNAL_HEADER_SIZE = sizeof(void*);     // just a pointer
+
+	enum HBLOCK_TYPE{hbNone, hbBasic, hbExtended, hbExternal};
+	enum ALLOCATION_POLICY{apFreeList, apFullestPage};  // one LIFO list, or fill the fullest partial page first
+	enum HEADER_LAYOUT{hlInline, hlSideTable};          // in front of every block, or in arrays in the page header
+	struct HeaderBlockInfo
+	{
+		HBLOCK_TYPE type_;
+		size_t size_;
+		size_t additional_;
+		HeaderBlockInfo(HBLOCK_TYPE type = hbNone, unsigned additional = 0) : type_(type), size_(0), additional_(additional)
+		{
+			if (type_ == hbBasic)
+				size_ = BASIC_HEADER_SIZE;
+			else if (type_ == hbExtended) // alloc # + use counter + flag byte + user-defined
+				size_ = sizeof(unsigned int) + sizeof(unsigned short) + sizeof(char) + additional_;
+			else if (type_ == hbExternal)
+				size_ = EXTERNAL_HEADER_SIZE;
+		};
+	};
+
+	OAConfig(bool UseCPPMemManager = false,
+					 unsigned ObjectsPerPage = DEFAULT_OBJECTS_PER_PAGE, 
+		       unsigned MaxPages = DEFAULT_MAX_PAGES, 
+					 bool DebugOn = false, 
+					 unsigned PadBytes = 0,
+					 const HeaderBlockInfo &HBInfo = HeaderBlockInfo(),
+					 unsigned Alignment = 0) : UseCPPMemManager_(UseCPPMemManager),
+											   ObjectsPerPage_(ObjectsPerPage), 
+											   MaxPages_(MaxPages), 
+					                           DebugOn_(DebugOn), 
+											   PadBytes_(PadBytes),
+											   HBlockInfo_(HBInfo),
+											   Alignment_(Alignment)
+	{
+		HBlockInfo_ = HBInfo;
+		LeftAlignSize_ = 0;  
+		InterAlignSize_ = 0;
+		EmptyPageThreshold_ = 0.0f;
+		ThreadCacheSize_ = 0;
+		LockFree_ = false;
+		PageSource_ = nullptr;
+		LazyCarving_ = false;
+		Policy_ = apFreeList;
+		ValidateFreed_ = false;
+		Profiler_ = nullptr;
+		HeaderLayout_ = hlInline;
+		Region_ = false;
+		QuarantineSize_ = 0;
+		CheckQuarantine_ = true;
+		UseAfterFree_ = nullptr;
+	}
+
+	bool UseCPPMemManager_;       // by-pass the functionality of the OA and use new/delete (padded and checked if DebugOn_)
+  unsigned ObjectsPerPage_;       // number of objects on each page
+  unsigned MaxPages_;             // maximum number of pages the OA can allocate (0=unlimited)
+	bool DebugOn_;                // enable/disable debugging code (signatures, checks, etc.)
+	unsigned PadBytes_;           // size of the left/right padding for each block
+	HeaderBlockInfo HBlockInfo_;  // size of the header for each block (0=no headers)
+	unsigned Alignment_;          // address alignment of each block (a power of two, 0=none)
+
+	unsigned LeftAlignSize_;      // number of alignment bytes required to align first block
+	unsigned InterAlignSize_;     // number of alignment bytes required between remaining blocks
+
+	float EmptyPageThreshold_;    // fraction of capacity that may sit free before empty pages are released (0=never)
+	unsigned ThreadCacheSize_;    // free objects each thread may keep to itself (0=not thread safe)
+	bool LockFree_;               // share one lock-free free list between threads (no headers or thread caches)
+	PageSource *PageSource_;      // where pages come from, has to outlive the allocator (nullptr=the heap)
+	bool LazyCarving_;            // hand out a new page's objects as they're needed instead of all up front
+	ALLOCATION_POLICY Policy_;    // which free object Allocate hands out next
+	bool ValidateFreed_;          // ValidatePages also reports free objects that were written to (debug only)
+	AllocationProfiler *Profiler_; // samples allocations when built with OA_PROFILING, has to outlive the allocator (nullptr=off)
+	HEADER_LAYOUT HeaderLayout_;  // where block headers live (hlSideTable=blocks are just object and pads, labels interned)
+	bool Region_;                 // objects are bumped off the pages, Free only checks and Reset takes them all back
+	unsigned QuarantineSize_;     // freed objects held back, oldest first, before they can be reused (0=none)
+	bool CheckQuarantine_;        // fill quarantined objects and check the fill when they leave the quarantine
+	void (*UseAfterFree_)(const void *, size_t); // told about objects written to in quarantine (nullptr=written to std::cerr)
+	
+};
+
+// ObjectAllocator statistical info
+struct OAStats
+{
+	OAStats(void) : ObjectSize_(0), PageSize_(0), FreeObjects_(0), ObjectsInUse_(0), PagesInUse_(0),
+                  MostObjects_(0), Allocations_(0), Deallocations_(0), Fragmentation_(0.0f) {};
+
+	size_t ObjectSize_;       // size of each object
+	size_t PageSize_;         // size of a page including all headers, padding, etc.
+	unsigned FreeObjects_;    // number of objects on the free list
+	unsigned ObjectsInUse_;   // number of objects in use by client
+	unsigned PagesInUse_;     // number of pages allocated
+	unsigned MostObjects_;    // most objects in use by client at one time
+	unsigned Allocations_;    // total requests to allocate memory
+	unsigned Deallocations_;  // total requests to free memory
+	float Fragmentation_;     // fraction of capacity that is free but stuck on pages still in use
+};
+
+// What GetTelemetry reads, from any thread and without taking a lock
+// Each counter is read on its own, so a snapshot taken while objects are moving can be off by those objects
+struct OATelemetry
+{
+	OATelemetry(void) : Allocations_(0), Deallocations_(0), ObjectsInUse_(0), PagesInUse_(0), MostPages_(0),
+	                    PagesFreed_(0), BytesReserved_(0), BytesUsed_(0), OverheadRatio_(0.0f) {};
+
+	std::uint64_t Allocations_;    // total objects handed out
+	std::uint64_t Deallocations_;  // total objects given back
+	std::uint64_t ObjectsInUse_;   // objects out with the client right now
+	unsigned PagesInUse_;          // pages held right now
+	unsigned MostPages_;           // most pages held at one time
+	std::uint64_t PagesFreed_;     // total pages given back to the page source
+	size_t BytesReserved_;         // memory held for objects (whole pages, or each system block)
+	size_t BytesUsed_;             // object bytes out with the client
+	float OverheadRatio_;          // fraction of BytesReserved_ that isn't client objects
+};
+
+// This allows us to easily treat raw objects as nodes in a linked list
+struct GenericObject
+{
+  GenericObject *Next;
+};
+
+struct MemBlockInfo
+{
+	MemBlockInfo(bool inUse, const char* userLabel, unsigned allocNumber);
+	~MemBlockInfo();
+	bool in_use;         // Is the block free or in use?
+	char *label;         // A dynamically allocated NUL-terminated string
+	unsigned alloc_num;  // The allocation number (count) of this block
+};
+
+// A copy of one block's header, read the same way for either header layout
+struct OAHeader
+{
+	bool InUse;                // is the block in use?
+	unsigned AllocNum;         // the allocation number (count) of this block
+	unsigned short UseCount;   // times the block has been handed out (extended only)
+	const char *Label;         // the label it was allocated with (external only, nullptr=none)
+	const char *UserData;      // the user-defined bytes (extended only)
+};
+
+// This memory manager class 
+class ObjectAllocator
+{
+  public:
+  
+  	// Defined by the client (pointer to a block, size of block)
+	typedef void (*DUMPCALLBACK)(const void *, size_t);
+	typedef void (*VALIDATECALLBACK)(const void *, size_t);
+
+	// Predefined values for memory signatures
+	static const unsigned char UNALLOCATED_PATTERN = 0xAA;
+	static const unsigned char ALLOCATED_PATTERN = 0xBB;
+	static const unsigned char FREED_PATTERN = 0xCC;
+	static const unsigned char PAD_PATTERN = 0xDD;
+	static const unsigned char ALIGN_PATTERN = 0xEE;
+
+    // Creates the ObjectManager per the specified values
+    // Throws an exception if the construction fails. (Memory allocation problem)
+    ObjectAllocator(size_t ObjectSize, const OAConfig& config);
+
+    // Destroys the ObjectManager (never throws)
+    ~ObjectAllocator();
+
+    // Take an object from the free list and give it to the client (simulates new)
+    // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    void *Allocate(const char *label = 0);
+
+    // Returns an object to the free list for the client (simulates delete)
+    // Throws an exception if the the object can't be freed. (Invalid object)
+    // A quarantined object found written to on the way out goes to UseAfterFree_, Free never throws about it
+    void Free(void *Object);
+
+    // Fills Objects with Count objects from the free list, all or nothing
+    // Throws an exception if the objects can't be allocated. (Memory allocation problem)
+    void AllocateBatch(void **Objects, size_t Count);
+
+    // Returns Count objects to the free list, the ones before a bad object are still freed
+    // Throws an exception if one of the objects can't be freed. (Invalid object)
+    void FreeBatch(void * const *Objects, size_t Count);
+
+    // Returns true if the address is somewhere on one of this allocator's pages
+    // With UseCPPMemManager_ only objects tracked in debug mode are recognized
+    bool Owns(const void *Object) const;
+
+    // Calls the callback fn for each block still in use
+    unsigned DumpMemoryInUse(DUMPCALLBACK fn) const;
+
+    // Calls fn(void *Object) for each object in use, in address order, returns the number visited
+    // Not thread safe and fn can't allocate or free, objects in thread caches count as in use
+    // With UseCPPMemManager_ only objects tracked in debug mode are visited, like DumpMemoryInUse
+    template <typename Callable>
+    unsigned ForEachLive(Callable fn) const;
+
+    // Calls the callback fn for each block that is potentially corrupted
+	unsigned ValidatePages(VALIDATECALLBACK fn) const;
+
+    // Splits the pages between Threads workers (0=one per core), fn is still only called from this thread
+	unsigned ValidatePages(VALIDATECALLBACK fn, unsigned Threads) const;
+
+	// Frees all empty pages (extra credit), returns the number of pages freed
+	unsigned FreeEmptyPages(void);
+
+	// Returns true if FreeEmptyPages and alignments are implemented
+	static bool ImplementedExtraCredit(void);
+
+	// Gives every thread's cached objects back to the shared free list
+	void FlushThreadCaches(void);
+
+	// Region mode: takes back every object at once and keeps the pages for the next cycle
+	// O(1), or a pass over the used pages to put the signatures back when debugging
+	// With OA_PROFILING the profiler forgets this allocator's sampled objects in one pass
+	void Reset(void);
+
+	// Moves every quarantined object onto the free list, checking each one on the way
+	// Throws an exception naming the first one that was written to if there is no UseAfterFree_,
+	// every object has already been released by then. (Corrupted object)
+	void FlushQuarantine(void);
+
+    // Testing/Debugging/Statistic methods
+    void SetDebugState(bool State);           // true=enable, false=disable
+    const void *GetFreeList(void) const;      // returns a pointer to the internal free list
+    const void *GetPageList(void) const;      // returns a pointer to the internal page list
+		OAConfig GetConfig(void) const;       // returns the configuration parameters
+		OAStats GetStats(void) const;         // returns the statistics for the allocator
+    bool GetHeader(const void *Object, OAHeader &Header) const; // reads a block's header (false=no headers or not a block)
+    OATelemetry GetTelemetry(void) const;     // returns the lock-free counters, safe to call from any thread at any time
+
+  private:
+  
+    // Moves objects between pages when compacting
+    friend class HandleAllocator;
+
+    // One bit per block on a page, set while the client owns the block
+    typedef std::uint64_t BlockMapWord;
+    static const unsigned BLOCKS_PER_WORD = sizeof(BlockMapWord) * 8;
+
+    GenericObject *PageList_;           // the beginning of the list of pages
+    GenericObject *FreeList_;           // the beginning of the list of objects
+    std::vector<char*> PageIndex_;      // every page, sorted by address
+    unsigned EmptyPages_;               // number of pages with no objects in use
+    char *CarvePage_;                   // newest page while it has objects nobody has touched (lazy carving)
+    unsigned CarveNext_;                // first untouched object on CarvePage_
+    std::vector<char*> RegionPages_;    // every page in the order the region fills them (region mode)
+    size_t RegionIndex_;                // the page in RegionPages_ being filled
+    unsigned RegionNext_;               // next object on that page, anything past it is from before the last Reset
+    std::vector<void*> Quarantine_;     // freed objects waiting to be reused, a ring of QuarantineSize_
+    size_t QuarantineHead_;             // the oldest object in Quarantine_
+    size_t QuarantineCount_;            // how many objects are in Quarantine_
+
+    // Fullest page first, pages grouped by how full they are (full pages aren't in any bin)
+    static const unsigned PARTIAL_BINS = 8;           // bins for pages with objects in use, bin 0 is empty pages
+    std::vector<char*> PageBins_[PARTIAL_BINS + 1];  // the pages in each bin, in no order
+	OAConfig Configuration_;            // the configuration for the allocator
+	OAStats Statistics_;                // the stats for the allocator
+
+    // Thread caching, only used when ThreadCacheSize_ is set
+    struct Magazine;                    // one thread's cache of free objects
+    friend class ThreadCacheTable;      // hands each thread its magazines
+    std::atomic<bool> UseThreadCache_;  // true while Allocate/Free can skip the shared lock
+    mutable std::mutex DepotLock_;      // guards everything above while thread caching
+    std::vector<Magazine*> Magazines_;  // every magazine handed out so far (guarded by DepotLock_)
+    unsigned long long Id_;             // never reused, so stale thread caches can't match a new allocator
+
+    // Lock-free free list, only used when LockFree_ is set
+    bool LockFree_;                                 // Allocate/Free go through LockFreeHead_
+    std::atomic<std::uint64_t> LockFreeHead_;       // top of the free list packed with an ABA tag
+    std::atomic<unsigned> LockFreeAllocations_;     // requests handled by the lock-free list
+    std::atomic<unsigned> LockFreeDeallocations_;   // frees handled by the lock-free list
+
+    // Telemetry, always kept so a monitoring thread can read it without a lock
+    static const unsigned TELEMETRY_SHARDS = 16;   // threads are spread over these so they don't share cache lines
+    struct alignas(64) TelemetryShard
+    {
+      std::atomic<std::uint64_t> Allocations;      // objects handed out by the threads on this shard
+      std::atomic<std::uint64_t> Deallocations;    // objects given back by the threads on this shard
+    };
+    TelemetryShard TelemetryShards_[TELEMETRY_SHARDS];
+    std::atomic<std::uint64_t> TelemetryReset_;    // objects taken back by Reset instead of Free
+    std::atomic<unsigned> TelemetryPages_;         // Statistics_.PagesInUse_, published when it changes
+    std::atomic<unsigned> TelemetryMostPages_;     // the highest TelemetryPages_ has been
+    std::atomic<std::uint64_t> TelemetryPagesFreed_; // pages given back to the page source
+
+    // System heap objects, only used when UseCPPMemManager_ is set
+    bool SystemDebug_;                      // padded, signed and tracked, fixed at construction so Free matches Allocate
+    std::unordered_set<void*> SystemObjects_; // objects out with the client (SystemDebug_ only)
+
+    // Side table headers, only used when HeaderLayout_ is hlSideTable
+    struct SideTable
+    {
+      size_t AllocNums;  // offset of an unsigned per block
+      size_t Labels;     // offset of an unsigned per block, the label's id (external only, 0=none)
+      size_t UseCounts;  // offset of an unsigned short per block (extended only)
+      size_t Flags;      // offset of a byte per block, 1 while in use
+      size_t UserData;   // offset of the user-defined bytes for each block (extended only)
+      size_t Size;       // the whole table, rounded up to a block map word
+    };
+    SideTable SideTable_;                                      // where each array sits after the block map
+    std::deque<std::string> Labels_;                           // every label seen so far, ids are the index + 1
+    std::unordered_map<std::string_view, unsigned> LabelIds_;  // label text to id, the views point into Labels_
+
+    void allocate_new_page(void);                               // allocates another page of objects
+	void *allocate_object(const char *label);                   // Allocate without the profiler
+	void free_object(void *Object);                             // does the work of Free
+	void record_free(void *Object);                             // counts a released object in the telemetry and the profiler
+	void set_side_table(void);                                  // works out where each header array sits in a page
+	size_t get_inline_header_size(void) const;                  // gets the header bytes in front of each block (0=side table)
+	char *get_side_table(const char *Page) const;               // gets the start of a page's header arrays
+	unsigned intern_label(const char *Label);                   // gets the id for a label, copying it the first time only
+	void set_side_header(char *Page, void *Object, unsigned LabelId); // fills in a block's side table entries when allocated
+	void free_side_header(char *Page, void *Object);            // clears a block's side table entries when freed
+	void clear_side_header(char *Page, unsigned Index);         // zeroes every side table entry for a block
+	void move_header(char *FromPage, void *From, char *ToPage, void *To); // moves a block's header along with it
+	void *allocate_region(unsigned LabelId);                    // bumps the next object off the region's pages
+	bool free_region(void *Object);                             // checks and marks a region object, false if it was stale
+	unsigned free_region_pages(void);                           // releases the pages past the region's cursor
+	void quarantine_object(char *Page, void *Object);           // holds a freed object back, releasing the oldest when full
+	bool release_quarantined(void *Object);                     // puts an object from the quarantine on the free list (false=written to)
+	void report_use_after_free(void *Object) const;             // tells UseAfterFree_ (or std::cerr) about a quarantined object that was written to
+	void *allocate_system(void);                                // gets an object from operator new
+	void free_system(void *Object);                             // gives an object from allocate_system back to operator delete
+	void release_system_block(char *Block) const;               // deletes a block the way allocate_system got it
+	size_t get_system_offset(void) const;                       // gets the bytes in front of a system heap object
+	size_t get_system_alignment(void) const;                    // gets the alignment system heap blocks need (0=default)
+	void get_system_objects(std::vector<void*> &Objects) const; // gets the tracked system heap objects in address order
+	void allocate_objects(char *page);                          // allocates the objects on the new page
+	void refill_free_list(void);                                // gets at least one object onto an empty free list
+	void carve_object(void);                                    // moves the next untouched object onto the free list
+	void set_block_bytes(char *Page, unsigned Index);           // places the signatures around a single block
+	int get_page_bin(unsigned LiveCount) const;                 // gets the bin for a page with LiveCount objects out (-1=full)
+	void move_page_bin(char *Page, unsigned OldCount);          // moves a page to its bin after its live count changes
+	void add_to_page_bin(char *Page, int Bin);                  // puts a page at the back of a bin
+	void remove_from_page_bin(char *Page, int Bin);             // takes a page out of a bin
+	char *get_fullest_page(void) const;                         // gets the fullest page with a free object (nullptr if none)
+	unsigned *get_bin_slot(const char *Page) const;             // gets where a page sits in its bin
+	unsigned find_free_block(const char *Page) const;           // gets the lowest free slot on a page
+	static unsigned lowest_set_bit(BlockMapWord Word);          // gets the index of the lowest set bit (Word!=0)
+	float get_fragmentation(const OAStats &Stats) const;        // gets the free capacity stuck on pages in use
+	unsigned get_carved_count(const char *Page) const;          // gets how many objects on a page have been touched
+    void put_on_freelist(void *Object);                         // puts Object onto the free list
+	void splice_onto_freelist(GenericObject *Head, GenericObject *Tail, unsigned Count); // puts a chain onto the free list
+	bool can_batch(void) const;                                 // checks if the batch calls can skip Allocate/Free
+	void check_double_free(char *Page, void *Object);           // checks if a freeing object has already been freed
+	char *check_within_bounds(void* Object);                    // checks if a passed pointer is within the bounds
+	void check_corrputed_pad(void* Object);                     // checks if the pads on the sides of an object have been touched
+	void set_padding_bytes(char* Page);                         // goes to the correct bytes and places pad byte signatures
+	void set_alignment_bytes(char* Page);                       // goes to the correct bytes and places alignment signatures
+	void set_header_bytes(char* Page);                          // goes to the correct bytes and clears the data
+	void set_header_data(void* Object);                         // Sets the correct data inside of a header when allocated
+	void set_external_header(void* Object, const char* label);  // Allocates and sets up an external header
+	void free_header_data(void* Object);                        // frees the appropriate data in the header
+	size_t get_size_of_header() const;                          // gets the size of the beginning portion of a page
+	size_t get_size_of_object() const;                          // gets the size of a full object
+	size_t get_page_alignment() const;                          // gets the alignment every page is allocated at
+	void delete_page(char *Page);                               // gives a page's memory back to the system
+	size_t get_block_map_words() const;                         // gets the number of words in a page's block map
+	unsigned *get_live_count(const char *Page) const;           // gets the count of objects in use on a page
+	BlockMapWord *get_block_map(const char *Page) const;        // gets the block map at the front of a page
+	char *get_object(const char *Page, unsigned Index) const;   // gets the object at a slot of a page
+	unsigned get_block_index(const char *Page, const void *Object) const; // gets the slot of an object on a page
+	char *find_page(const void *Object) const;                  // gets the page that holds an address (nullptr if none)
+	void add_to_page_index(char *Page);                         // inserts a page into the sorted page index
+	void set_block_state(char *Page, void *Object, bool InUse); // marks an object as in use or free in the block map
+	bool is_block_in_use(const char *Page, unsigned Index) const; // checks the block map for a slot
+	void take_from_page(char *Page, void *Object);              // updates a page's bookkeeping when an object is handed out
+	void give_to_page(char *Page, void *Object);                // updates a page's bookkeeping when an object comes back
+	bool should_free_empty_pages(void) const;                   // checks the empty page policy
+	unsigned free_empty_pages(void);                            // FreeEmptyPages without taking the lock
+	void update_thread_cache_state(void);                       // decides if Allocate/Free can use the thread caches
+	void *allocate_cached(void);                                // takes an object from this thread's magazine
+	void free_cached(void *Object);                             // puts an object in this thread's magazine
+	Magazine *get_magazine(void);                               // finds or hands out this thread's magazine
+	void refill_magazine(Magazine *Cache);                      // moves a batch from the free list to a magazine
+	void drain_magazine(Magazine *Cache, unsigned Count);       // moves a batch from a magazine to the free list
+	void release_magazine(Magazine *Cache);                     // empties a magazine when its thread goes away
+	void *allocate_lock_free(void);                             // pops an object off the lock-free list
+	void free_lock_free(void *Object);                          // pushes an object onto the lock-free list
+	void publish_free_list(void);                               // moves FreeList_ onto the lock-free list
+	TelemetryShard &get_telemetry_shard(void);                  // the calling thread's telemetry counters
+	void publish_pages(unsigned Freed);                         // copies the page count into the telemetry
+	static std::uint64_t pack_head(GenericObject *Object, std::uint64_t OldHead); // builds the list head that follows OldHead
+	static GenericObject *unpack_head(std::uint64_t Head);      // gets the object out of a tagged list head
+	void lock_magazines(std::vector<Magazine*> &Caches,         // locks every magazine handed out so far
+	                    std::vector<std::unique_lock<std::mutex> > &Locks) const;
+	bool is_corrupted(void* Object) const;                      // checks if an object has corrupted pad bytes
+	bool is_freed_overwritten(const char *Page, unsigned Index) const; // checks if a free object lost its fill
+	void validate_page(const char *Page, std::vector<void*> &Corrupted) const; // collects a page's corrupted objects
+
+      // Make private to prevent copy construction and assignment
+    ObjectAllocator(const ObjectAllocator &oa);
+    ObjectAllocator &operator=(const ObjectAllocator &oa);
+	
+};
+
+// Calls fn(void *Object) for each object in use, in address order, returns the number visited
+template <typename Callable>
+unsigned ObjectAllocator::ForEachLive(Callable fn) const
+{
+  // The lock-free list doesn't keep the block maps
+  if (LockFree_)
+    return 0;
+
+  // The system heap has no pages, only the objects debug mode tracks
+  if (Configuration_.UseCPPMemManager_)
+  {
+    std::vector<void*> objects;
+    get_system_objects(objects);
+
+    for (size_t i = 0; i < objects.size(); ++i)
+      fn(objects[i]);
+
+    return static_cast<unsigned>(objects.size());
+  }
+
+  unsigned visited = 0;
+  size_t words = get_block_map_words();
+  size_t stride = get_size_of_object();
+
+  // The index is sorted, so pages come in address order
+  for (size_t p = 0; p < PageIndex_.size(); ++p)
+  {
+    const char* page = PageIndex_[p];
+    unsigned live = *get_live_count(page);
+
+    // Nothing in use on this page, or nothing handed out on it since a region Reset
+    if (live == 0 || get_carved_count(page) == 0)
+      continue;
+
+    const BlockMapWord* map = get_block_map(page);
+    char* first = get_object(page, 0);
+
+    // Words with no bits set skip 64 free blocks at once, and the page is done once every live object is seen
+    for (size_t w = 0; w < words && live != 0; ++w)
+    {
+      for (BlockMapWord bits = map[w]; bits != 0; bits &= bits - 1)
+      {
+        fn(static_cast<void*>(first + stride * (w * BLOCKS_PER_WORD + lowest_set_bit(bits))));
+
+        ++visited;
+        --live;
+      }
+    }
+  }
+
+  return visited;
+}
+
+// gets the index of the lowest set bit (Word!=0)
+inline unsigned ObjectAllocator::lowest_set_bit(BlockMapWord Word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctzll(Word));
+#else
+  // Halve the search each step
+  unsigned index = 0;
+  if ((Word & 0xFFFFFFFFull) == 0) { Word >>= 32; index += 32; }
+  if ((Word & 0xFFFFull) == 0)     { Word >>= 16; index += 16; }
+  if ((Word & 0xFFull) == 0)       { Word >>= 8;  index += 8; }
+  if ((Word & 0xFull) == 0)        { Word >>= 4;  index += 4; }
+  if ((Word & 0x3ull) == 0)        { Word >>= 2;  index += 2; }
+  if ((Word & 0x1ull) == 0)        { index += 1; }
+
+  return index;
+#endif
+}
+
+#endif
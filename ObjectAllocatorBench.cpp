@@ -0,0 +1,1048 @@
+/*!*************************************************************************************************
+\file    ObjectAllocatorBench.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the allocator benchmarks. Build it with optimizations and the allocator
+         sources, g++ -std=c++17 -O2 -pthread ObjectAllocatorBench.cpp ObjectAllocator.cpp
+         PageSource.cpp PoolAllocator.cpp SmallObjectAllocator.cpp NumaObjectAllocator.cpp, then run
+         it with the suites to run (every suite without any) and --quick for shorter runs. Every
+         result is one CSV row on stdout, notes go to stderr. Latencies are timed one operation at a
+         time, so they include reading the clock.
+***************************************************************************************************/
+
+#include "ObjectAllocator.h"       // ObjectAllocator, OAConfig
+#include "NumaObjectAllocator.h"   // NumaObjectAllocator
+#include "PageSource.h"            // HeapPageSource, MmapPageSource, HugePageSource, NumaPageSource
+#include "PoolAllocator.h"         // NodePoolResource, PoolAllocator
+#include "SmallObjectAllocator.h"  // SmallObjectAllocator, SmallObjectResource
+#include <algorithm>               // std::sort, std::shuffle, std::min
+#include <atomic>                  // std::atomic
+#include <chrono>                  // std::chrono::steady_clock
+#include <cstdint>                 // std::uint32_t
+#include <cstdio>                  // printf, fprintf
+#include <cstdlib>                 // malloc, free
+#include <cstring>                 // strcmp
+#include <list>                    // std::list, std::pmr::list
+#include <map>                     // std::map, std::pmr::map
+#include <memory_resource>         // std::pmr::unsynchronized_pool_resource
+#include <mutex>                   // std::mutex, std::lock_guard
+#include <random>                  // std::mt19937
+#include <string>                  // std::string
+#include <thread>                  // std::thread
+#include <vector>                  // std::vector
+
+#if defined(__linux__)
+#include <linux/perf_event.h>      // perf_event_attr, PERF_COUNT_HW_CACHE_DTLB
+#include <sched.h>                 // sched_setaffinity, cpu_set_t
+#include <sys/ioctl.h>             // ioctl
+#include <sys/syscall.h>           // SYS_perf_event_open
+#include <unistd.h>                // syscall, read, close
+#define BENCH_HAS_PERF 1
+#else
+#define BENCH_HAS_PERF 0
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// Divides every operation count when running with --quick
+static unsigned Scale = 1;
+
+/***************************************************************************************************
+  Results
+***************************************************************************************************/
+
+// One CSV row
+struct Result
+{
+  std::string Suite;     // which suite it came from
+  std::string Workload;  // the allocation pattern
+  std::string Allocator; // what was allocating
+  std::string Config;    // how it was set up, key=value pairs split by ;
+  unsigned Threads;      // threads allocating and freeing
+  size_t Operations;     // allocations plus frees
+  double Seconds;        // wall time for every operation
+  double P50;            // nanoseconds per operation at each percentile (negative=not measured)
+  double P99;
+  double P999;
+  std::string Notes;     // anything else, key=value pairs split by ;
+};
+
+// Writes the header once, so the output can be read by name
+static void write_header(void)
+{
+  printf("suite,workload,allocator,config,threads,operations,ops_per_second,p50_ns,p99_ns,p999_ns,notes\n");
+}
+
+// Writes one result as a CSV row, unmeasured percentiles are left empty
+static void write_result(const Result &result)
+{
+  printf("%s,%s,%s,%s,%u,%zu,%.0f,", result.Suite.c_str(), result.Workload.c_str(), result.Allocator.c_str(),
+         result.Config.c_str(), result.Threads, result.Operations,
+         result.Seconds > 0.0 ? result.Operations / result.Seconds : 0.0);
+
+  if (result.P50 >= 0.0)
+    printf("%.0f,%.0f,%.0f,", result.P50, result.P99, result.P999);
+  else
+    printf(",,,");
+
+  printf("%s\n", result.Notes.c_str());
+  fflush(stdout);
+}
+
+// Seconds since Start
+static double seconds_since(Clock::time_point Start)
+{
+  return std::chrono::duration<double>(Clock::now() - Start).count();
+}
+
+// The value at a fraction of the way through sorted samples
+static double percentile(const std::vector<std::uint32_t> &Sorted, double Fraction)
+{
+  if (Sorted.empty())
+    return -1.0;
+
+  size_t index = static_cast<size_t>(Fraction * (Sorted.size() - 1));
+  return Sorted[index];
+}
+
+// Counts this thread's dTLB load misses between Start and Stop, where the system lets us
+class TlbMisses
+{
+  public:
+
+    TlbMisses() : Fd_(-1)
+    {
+#if BENCH_HAS_PERF
+      perf_event_attr attr = perf_event_attr();
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      // Fails in containers and VMs without a PMU, or when perf_event_paranoid says no
+      Fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~TlbMisses()
+    {
+#if BENCH_HAS_PERF
+      if (Fd_ >= 0)
+        close(Fd_);
+#endif
+    }
+
+    // Zeroes the count and starts counting
+    void Start(void)
+    {
+#if BENCH_HAS_PERF
+      if (Fd_ >= 0)
+      {
+        ioctl(Fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(Fd_, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    }
+
+    // Stops counting, returns the misses since Start (negative=can't be counted here)
+    long long Stop(void)
+    {
+      long long count = -1;
+
+#if BENCH_HAS_PERF
+      if (Fd_ >= 0)
+      {
+        ioctl(Fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(Fd_, &count, sizeof(count)) != sizeof(count))
+          count = -1;
+      }
+#endif
+
+      return count;
+    }
+
+  private:
+
+    int Fd_;  // the perf event (-1=not counting)
+
+    // Make private to prevent copy construction and assignment
+    TlbMisses(const TlbMisses &tm);
+    TlbMisses &operator=(const TlbMisses &tm);
+
+};
+
+/***************************************************************************************************
+  Allocators
+***************************************************************************************************/
+
+// Every allocator a workload runs against has the same two calls
+
+// The global operator new and delete
+struct NewBackend
+{
+  explicit NewBackend(size_t Size) : Size_(Size) {}
+  void *allocate(void) { return operator new(Size_); }
+  void free(void *Object) { operator delete(Object); }
+
+  size_t Size_;
+};
+
+// malloc and free
+struct MallocBackend
+{
+  explicit MallocBackend(size_t Size) : Size_(Size) {}
+  void *allocate(void) { return malloc(Size_); }
+  void free(void *Object) { ::free(Object); }
+
+  size_t Size_;
+};
+
+// One ObjectAllocator
+struct OABackend
+{
+  OABackend(size_t Size, const OAConfig &config) : Allocator_(Size, config) {}
+  void *allocate(void) { return Allocator_.Allocate(); }
+  void free(void *Object) { Allocator_.Free(Object); }
+
+  ObjectAllocator Allocator_;
+};
+
+// One ObjectAllocator behind a mutex, the way a client would share one without LockFree_
+struct LockedOABackend
+{
+  LockedOABackend(size_t Size, const OAConfig &config) : Allocator_(Size, config) {}
+  void *allocate(void) { std::lock_guard<std::mutex> lock(Lock_); return Allocator_.Allocate(); }
+  void free(void *Object) { std::lock_guard<std::mutex> lock(Lock_); Allocator_.Free(Object); }
+
+  ObjectAllocator Allocator_;
+  std::mutex Lock_;
+};
+
+/***************************************************************************************************
+  Workloads
+***************************************************************************************************/
+
+// A workload is a script of slot numbers, n allocates into slot n and ~n frees slot n
+enum WORKLOAD{wlLIFO, wlFIFO, wlRandom, wlBursty};
+static const char *WORKLOAD_NAMES[] = { "lifo", "fifo", "random", "bursty" };
+
+// One round of a workload over Count slots, every slot is free again at the end
+static std::vector<int> make_script(WORKLOAD Workload, int Count)
+{
+  std::vector<int> script;
+  std::mt19937 random(12345);
+
+  // Fill every slot, then free them in the workload's order
+  if (Workload != wlBursty)
+  {
+    std::vector<int> order;
+    for (int i = 0; i < Count; ++i)
+    {
+      script.push_back(i);
+      order.push_back(i);
+    }
+
+    if (Workload == wlLIFO)
+      std::reverse(order.begin(), order.end());
+    else if (Workload == wlRandom)
+      std::shuffle(order.begin(), order.end(), random);
+
+    for (size_t i = 0; i < order.size(); ++i)
+      script.push_back(~order[i]);
+
+    return script;
+  }
+
+  // Bursts of allocations, each followed by freeing a random part of what is live
+  std::vector<int> live;
+  std::vector<int> free;
+  for (int i = Count; i > 0; --i)
+    free.push_back(i - 1);
+
+  size_t allocations = 0;
+  while (allocations < static_cast<size_t>(Count))
+  {
+    size_t burst = 1 + random() % (Count / 4 + 1);
+    for (size_t i = 0; i < burst && !free.empty(); ++i, ++allocations)
+    {
+      live.push_back(free.back());
+      script.push_back(free.back());
+      free.pop_back();
+    }
+
+    // Between half and all of the live objects go back
+    std::shuffle(live.begin(), live.end(), random);
+    size_t frees = live.size() / 2 + random() % (live.size() / 2 + 1);
+    for (size_t i = 0; i < frees; ++i)
+    {
+      script.push_back(~live.back());
+      free.push_back(live.back());
+      live.pop_back();
+    }
+  }
+
+  // Whatever is left goes back at the end
+  for (size_t i = 0; i < live.size(); ++i)
+    script.push_back(~live[i]);
+
+  return script;
+}
+
+// Runs a script once, touching every object so nothing can be optimized out
+template <typename Backend>
+static void run_script(Backend &backend, const std::vector<int> &Script, std::vector<void*> &Slots)
+{
+  for (size_t i = 0; i < Script.size(); ++i)
+  {
+    int op = Script[i];
+    if (op >= 0)
+    {
+      Slots[op] = backend.allocate();
+      *static_cast<volatile char*>(Slots[op]) = 1;
+    }
+    else
+      backend.free(Slots[~op]);
+  }
+}
+
+// Runs a script Rounds times for throughput, then once more timing every operation
+template <typename Backend>
+static Result run_workload(Backend &backend, WORKLOAD Workload, int Count, unsigned Rounds)
+{
+  std::vector<int> script = make_script(Workload, Count);
+  std::vector<void*> slots(Count);
+
+  // Warm up, so the pages are already there
+  run_script(backend, script, slots);
+
+  Clock::time_point start = Clock::now();
+  for (unsigned r = 0; r < Rounds; ++r)
+    run_script(backend, script, slots);
+
+  Result result = Result();
+  result.Workload = WORKLOAD_NAMES[Workload];
+  result.Threads = 1;
+  result.Seconds = seconds_since(start);
+  result.Operations = script.size() * Rounds;
+
+  // Latency, one operation at a time
+  std::vector<std::uint32_t> samples;
+  samples.reserve(script.size());
+  for (size_t i = 0; i < script.size(); ++i)
+  {
+    int op = script[i];
+    Clock::time_point before = Clock::now();
+    if (op >= 0)
+    {
+      slots[op] = backend.allocate();
+      *static_cast<volatile char*>(slots[op]) = 1;
+    }
+    else
+      backend.free(slots[~op]);
+    samples.push_back(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count()));
+  }
+
+  std::sort(samples.begin(), samples.end());
+  result.P50 = percentile(samples, 0.50);
+  result.P99 = percentile(samples, 0.99);
+  result.P999 = percentile(samples, 0.999);
+
+  return result;
+}
+
+// A single producer/single consumer ring of objects, the producer allocates and the consumer frees
+template <typename Backend>
+static Result run_producer_consumer(Backend &backend, size_t Objects)
+{
+  static const size_t RING_SIZE = 1024;
+  std::vector<void*> ring(RING_SIZE);
+  std::atomic<size_t> head(0);  // next slot the consumer reads
+  std::atomic<size_t> tail(0);  // next slot the producer writes
+
+  Clock::time_point start = Clock::now();
+
+  std::thread consumer([&]()
+  {
+    for (size_t i = 0; i < Objects; ++i)
+    {
+      // Wait for the producer
+      while (head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+      backend.free(ring[i % RING_SIZE]);
+      head.store(i + 1, std::memory_order_release);
+    }
+  });
+
+  for (size_t i = 0; i < Objects; ++i)
+  {
+    void* object = backend.allocate();
+    *static_cast<volatile char*>(object) = 1;
+
+    // Wait for room in the ring
+    while (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) == RING_SIZE)
+      std::this_thread::yield();
+
+    ring[i % RING_SIZE] = object;
+    tail.store(i + 1, std::memory_order_release);
+  }
+
+  consumer.join();
+
+  Result result = Result();
+  result.Workload = "producer_consumer";
+  result.Threads = 2;
+  result.Operations = Objects * 2;
+  result.Seconds = seconds_since(start);
+  result.P50 = result.P99 = result.P999 = -1.0;
+
+  return result;
+}
+
+// Threads sharing one allocator, each allocating a batch and freeing it again, until Operations are done
+template <typename Backend>
+static Result run_threads(Backend &backend, unsigned Threads, size_t Operations)
+{
+  static const unsigned BATCH = 64;
+  const size_t rounds = Operations / (2 * BATCH * Threads) + 1;
+
+  // Every thread starts at once, so the first one isn't timed alone
+  std::atomic<unsigned> ready(0);
+  std::atomic<bool> go(false);
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < Threads; ++t)
+    threads.emplace_back([&]()
+    {
+      void* batch[BATCH];
+      ready.fetch_add(1);
+      while (!go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+      for (size_t r = 0; r < rounds; ++r)
+      {
+        for (unsigned i = 0; i < BATCH; ++i)
+        {
+          batch[i] = backend.allocate();
+          *static_cast<volatile char*>(batch[i]) = 1;
+        }
+
+        for (unsigned i = BATCH; i > 0; --i)
+          backend.free(batch[i - 1]);
+      }
+    });
+
+  while (ready.load() != Threads)
+    std::this_thread::yield();
+
+  Clock::time_point start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+
+  Result result = Result();
+  result.Workload = "batch_lifo";
+  result.Threads = Threads;
+  result.Operations = rounds * 2 * BATCH * Threads;
+  result.Seconds = seconds_since(start);
+  result.P50 = result.P99 = result.P999 = -1.0;
+
+  return result;
+}
+
+// Count shuffled numbers, the same every run
+static std::vector<int> make_keys(int Count, unsigned Seed)
+{
+  std::vector<int> keys;
+  for (int i = 0; i < Count; ++i)
+    keys.push_back(i);
+
+  std::mt19937 random(Seed);
+  std::shuffle(keys.begin(), keys.end(), random);
+  return keys;
+}
+
+// Fills a list, then erases every node in a random order, Rounds times
+template <typename List>
+static Result run_list(List &list, int Count, unsigned Rounds)
+{
+  std::vector<int> order = make_keys(Count, 12345);
+  std::vector<typename List::iterator> nodes(Count);
+
+  Clock::time_point start = Clock::now();
+  for (unsigned r = 0; r < Rounds; ++r)
+  {
+    for (int i = 0; i < Count; ++i)
+      nodes[i] = list.insert(list.end(), i);
+
+    for (int i = 0; i < Count; ++i)
+      list.erase(nodes[order[i]]);
+  }
+
+  Result result = Result();
+  result.Workload = "list";
+  result.Threads = 1;
+  result.Operations = size_t(Count) * 2 * Rounds;
+  result.Seconds = seconds_since(start);
+  result.P50 = result.P99 = result.P999 = -1.0;
+
+  return result;
+}
+
+// Inserts random keys into a map, then erases them in a different order, Rounds times
+template <typename Map>
+static Result run_map(Map &map, int Count, unsigned Rounds)
+{
+  std::vector<int> inserts = make_keys(Count, 12345);
+  std::vector<int> erases = make_keys(Count, 54321);
+
+  Clock::time_point start = Clock::now();
+  for (unsigned r = 0; r < Rounds; ++r)
+  {
+    for (int i = 0; i < Count; ++i)
+      map.emplace(inserts[i], i);
+
+    for (int i = 0; i < Count; ++i)
+      map.erase(erases[i]);
+  }
+
+  Result result = Result();
+  result.Workload = "map";
+  result.Threads = 1;
+  result.Operations = size_t(Count) * 2 * Rounds;
+  result.Seconds = seconds_since(start);
+  result.P50 = result.P99 = result.P999 = -1.0;
+
+  return result;
+}
+
+/***************************************************************************************************
+  Suites
+***************************************************************************************************/
+
+// Builds the config column for an ObjectAllocator
+static std::string describe(size_t Size, const OAConfig &config)
+{
+  static const char *HEADER_NAMES[] = { "none", "basic", "extended", "external" };
+
+  char text[160];
+  snprintf(text, sizeof(text), "size=%zu;objects_per_page=%u;pad=%u;header=%s;debug=%d;thread_cache=%u;lock_free=%d",
+           Size, config.ObjectsPerPage_, config.PadBytes_, HEADER_NAMES[config.HBlockInfo_.type_],
+           config.DebugOn_ ? 1 : 0, config.ThreadCacheSize_, config.LockFree_ ? 1 : 0);
+
+  return text;
+}
+
+// Runs one workload and writes its row
+template <typename Backend>
+static void write_workload(Backend &backend, const char *Suite, const char *Allocator, const std::string &Config,
+                           WORKLOAD Workload, int Count, unsigned Rounds)
+{
+  Result result = run_workload(backend, Workload, Count, Rounds);
+  result.Suite = Suite;
+  result.Allocator = Allocator;
+  result.Config = Config;
+  write_result(result);
+}
+
+// Runs the producer/consumer workload and writes its row
+template <typename Backend>
+static void write_producer_consumer(Backend &backend, const char *Suite, const char *Allocator, const std::string &Config,
+                                    size_t Objects)
+{
+  Result result = run_producer_consumer(backend, Objects);
+  result.Suite = Suite;
+  result.Allocator = Allocator;
+  result.Config = Config;
+  write_result(result);
+}
+
+// Every workload against new, malloc and a release ObjectAllocator, at a few object sizes
+static void suite_patterns(void)
+{
+  const size_t sizes[] = { 16, 64, 256 };
+  const int count = 10000;
+  const unsigned rounds = 100 / Scale;
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+  {
+    size_t size = sizes[s];
+    char sizeConfig[32];
+    snprintf(sizeConfig, sizeof(sizeConfig), "size=%zu", size);
+
+    for (int w = wlLIFO; w <= wlBursty; ++w)
+    {
+      NewBackend newBackend(size);
+      write_workload(newBackend, "patterns", "new", sizeConfig, WORKLOAD(w), count, rounds);
+
+      MallocBackend mallocBackend(size);
+      write_workload(mallocBackend, "patterns", "malloc", sizeConfig, WORKLOAD(w), count, rounds);
+
+      OAConfig config(false, 1024, 0);
+      OABackend oaBackend(size, config);
+      write_workload(oaBackend, "patterns", "ObjectAllocator", describe(size, config), WORKLOAD(w), count, rounds);
+    }
+
+    // Across threads, so the allocator has to be thread safe
+    const size_t objects = 2000000 / Scale;
+
+    NewBackend newBackend(size);
+    write_producer_consumer(newBackend, "patterns", "new", sizeConfig, objects);
+
+    MallocBackend mallocBackend(size);
+    write_producer_consumer(mallocBackend, "patterns", "malloc", sizeConfig, objects);
+
+    OAConfig config(false, 1024, 0);
+    config.ThreadCacheSize_ = 64;
+    OABackend cachedBackend(size, config);
+    write_producer_consumer(cachedBackend, "patterns", "ObjectAllocator", describe(size, config), objects);
+
+    config.ThreadCacheSize_ = 0;
+    config.LockFree_ = true;
+    OABackend lockFreeBackend(size, config);
+    write_producer_consumer(lockFreeBackend, "patterns", "ObjectAllocator", describe(size, config), objects);
+  }
+}
+
+// ObjectsPerPage_, PadBytes_, the header types and DebugOn_ against each other
+static void suite_sweep(void)
+{
+  const unsigned pages[] = { 16, 64, 256, 1024 };
+  const unsigned pads[] = { 0, 16 };
+  const OAConfig::HBLOCK_TYPE headers[] = { OAConfig::hbNone, OAConfig::hbBasic, OAConfig::hbExtended, OAConfig::hbExternal };
+  const size_t size = 64;
+  const int count = 4096;
+  const unsigned rounds = 20 / Scale + 1;
+
+  for (size_t p = 0; p < sizeof(pages) / sizeof(pages[0]); ++p)
+    for (size_t d = 0; d < sizeof(pads) / sizeof(pads[0]); ++d)
+      for (size_t h = 0; h < sizeof(headers) / sizeof(headers[0]); ++h)
+        for (int debug = 0; debug <= 1; ++debug)
+        {
+          OAConfig config(false, pages[p], 0, debug != 0, pads[d], OAConfig::HeaderBlockInfo(headers[h], 4));
+
+          OABackend lifo(size, config);
+          write_workload(lifo, "sweep", "ObjectAllocator", describe(size, config), wlLIFO, count, rounds);
+
+          OABackend random(size, config);
+          write_workload(random, "sweep", "ObjectAllocator", describe(size, config), wlRandom, count, rounds);
+        }
+}
+
+// Runs the threaded workload and writes its row
+template <typename Backend>
+static void write_threads(Backend &backend, const char *Suite, const char *Allocator, const std::string &Config,
+                          unsigned Threads, size_t Operations)
+{
+  Result result = run_threads(backend, Threads, Operations);
+  result.Suite = Suite;
+  result.Allocator = Allocator;
+  result.Config = Config;
+
+  // Past this many threads they are taking turns, not running together
+  char notes[32];
+  snprintf(notes, sizeof(notes), "cpus=%u", std::thread::hardware_concurrency());
+  result.Notes = notes;
+
+  write_result(result);
+}
+
+// The lock-free list against one ObjectAllocator behind a mutex, from 1 to 64 threads
+static void suite_lockfree(void)
+{
+  const unsigned threads[] = { 1, 2, 4, 8, 16, 32, 64 };
+  const size_t size = 64;
+  const size_t operations = 8000000 / Scale;
+
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+  {
+    OAConfig config(false, 1024, 0);
+    LockedOABackend locked(size, config);
+    write_threads(locked, "lockfree", "ObjectAllocator+mutex", describe(size, config), threads[t], operations);
+
+    config.LockFree_ = true;
+    OABackend lockFree(size, config);
+    write_threads(lockFree, "lockfree", "ObjectAllocator", describe(size, config), threads[t], operations);
+
+    // The other way to share one, for reference
+    config.LockFree_ = false;
+    config.ThreadCacheSize_ = 64;
+    OABackend cached(size, config);
+    write_threads(cached, "lockfree", "ObjectAllocator", describe(size, config), threads[t], operations);
+  }
+}
+
+// Names a container run and writes its row
+static void write_container(Result result, const char *Allocator, int Count)
+{
+  char config[32];
+  snprintf(config, sizeof(config), "nodes=%d", Count);
+
+  result.Suite = "pmr";
+  result.Allocator = Allocator;
+  result.Config = config;
+  write_result(result);
+}
+
+// std::list and std::map nodes from std::allocator, the standard pool resource and the ObjectAllocator ones
+static void suite_pmr(void)
+{
+  const int counts[] = { 1000, 100000 };
+  const unsigned work = 10000000 / Scale;
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+  {
+    int count = counts[c];
+    unsigned rounds = work / (2 * count) + 1;
+
+    // Every resource is made fresh, so none starts with the pages of the one before
+    {
+      std::list<int> list;
+      write_container(run_list(list, count, rounds), "std::allocator", count);
+    }
+    {
+      std::pmr::unsynchronized_pool_resource pool;
+      std::pmr::list<int> list(&pool);
+      write_container(run_list(list, count, rounds), "unsynchronized_pool_resource", count);
+    }
+    {
+      NodePoolResource pool;
+      std::pmr::list<int> list(&pool);
+      write_container(run_list(list, count, rounds), "NodePoolResource", count);
+    }
+    {
+      NodePoolResource pool;
+      std::list<int, PoolAllocator<int> > list{PoolAllocator<int>(&pool)};
+      write_container(run_list(list, count, rounds), "PoolAllocator", count);
+    }
+    {
+      SmallObjectAllocator soa;
+      SmallObjectResource pool(soa);
+      std::pmr::list<int> list(&pool);
+      write_container(run_list(list, count, rounds), "SmallObjectResource", count);
+    }
+
+    {
+      std::map<int, int> map;
+      write_container(run_map(map, count, rounds), "std::allocator", count);
+    }
+    {
+      std::pmr::unsynchronized_pool_resource pool;
+      std::pmr::map<int, int> map(&pool);
+      write_container(run_map(map, count, rounds), "unsynchronized_pool_resource", count);
+    }
+    {
+      NodePoolResource pool;
+      std::pmr::map<int, int> map(&pool);
+      write_container(run_map(map, count, rounds), "NodePoolResource", count);
+    }
+    {
+      NodePoolResource pool;
+      std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int> > >
+        map{PoolAllocator<std::pair<const int, int> >(&pool)};
+      write_container(run_map(map, count, rounds), "PoolAllocator", count);
+    }
+    {
+      SmallObjectAllocator soa;
+      SmallObjectResource pool(soa);
+      std::pmr::map<int, int> map(&pool);
+      write_container(run_map(map, count, rounds), "SmallObjectResource", count);
+    }
+  }
+}
+
+// Kilobytes of this process backed by transparent huge pages (negative=can't tell)
+static long read_anon_huge_kb(void)
+{
+  long total = -1;
+
+#if defined(__linux__)
+  FILE* file = fopen("/proc/self/smaps_rollup", "r");
+  if (file == nullptr)
+    return -1;
+
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr)
+  {
+    long kb = 0;
+    if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+      total = kb;
+  }
+
+  fclose(file);
+#endif
+
+  return total;
+}
+
+// Fills a big pool from one page source, then reads its objects in a random order Passes times
+// Writes a fill row and a touch row, the touch row notes the dTLB misses when they can be counted
+static void run_pages(const char *Suite, PageSource *Source, const char *Allocator, const std::string &Notes,
+                      size_t Objects, unsigned Passes)
+{
+  const size_t size = 64;
+  OAConfig config(false, 4096, 0);
+  config.PageSource_ = Source;
+
+  std::vector<void*> objects(Objects);
+  std::vector<std::uint32_t> order(Objects);
+  for (size_t i = 0; i < Objects; ++i)
+    order[i] = static_cast<std::uint32_t>(i);
+  std::mt19937 random(12345);
+  std::shuffle(order.begin(), order.end(), random);
+
+  ObjectAllocator oa(size, config);
+
+  // Every page is new, so this is mostly the source handing them out
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < Objects; ++i)
+  {
+    objects[i] = oa.Allocate();
+    *static_cast<std::uint64_t*>(objects[i]) = i;
+  }
+
+  Result fill = Result();
+  fill.Suite = Suite;
+  fill.Workload = "fill";
+  fill.Allocator = Allocator;
+  fill.Config = describe(size, config);
+  fill.Threads = 1;
+  fill.Operations = Objects;
+  fill.Seconds = seconds_since(start);
+  fill.P50 = fill.P99 = fill.P999 = -1.0;
+
+  // Whether the system really backed the pool with huge pages
+  char text[64];
+  long hugeKB = read_anon_huge_kb();
+  if (hugeKB >= 0)
+    snprintf(text, sizeof(text), "anon_huge_kb=%ld", hugeKB);
+  else
+    snprintf(text, sizeof(text), "anon_huge_kb=unavailable");
+  fill.Notes = Notes.empty() ? text : Notes + ";" + text;
+  write_result(fill);
+
+  // Random reads across the whole pool are what the TLB can't cover with small pages
+  TlbMisses misses;
+  std::uint64_t sum = 0;
+  start = Clock::now();
+  misses.Start();
+  for (unsigned p = 0; p < Passes; ++p)
+    for (size_t i = 0; i < Objects; ++i)
+      sum += *static_cast<volatile std::uint64_t*>(objects[order[i]]);
+  long long counted = misses.Stop();
+
+  Result touch = fill;
+  touch.Workload = "random_touch";
+  touch.Operations = Objects * Passes;
+  touch.Seconds = seconds_since(start);
+
+  if (counted >= 0)
+    snprintf(text, sizeof(text), ";dtlb_misses=%lld", counted);
+  else
+    snprintf(text, sizeof(text), ";dtlb_misses=unavailable");
+  touch.Notes += text;
+  write_result(touch);
+
+  // Keeps the reads from being optimized out
+  if (sum != std::uint64_t(Objects) * (Objects - 1) / 2 * Passes)
+    fprintf(stderr, "%s: the objects didn't read back what was written\n", Suite);
+
+  for (size_t i = 0; i < Objects; ++i)
+    oa.Free(objects[i]);
+}
+
+// The heap, 4K mmap pages and huge pages under one big pool
+static void suite_pages(void)
+{
+  const size_t objects = (1u << 20) / Scale;
+  const unsigned passes = 4;
+
+  run_pages("pages", HeapPageSource::GetDefault(), "ObjectAllocator+heap", "", objects, passes);
+
+  {
+    MmapPageSource source;
+    run_pages("pages", &source, "ObjectAllocator+mmap", "", objects, passes);
+  }
+
+  // Reserved huge pages are only tried once the first region is mapped, so map one up front to know which
+  HugePageSource source;
+  source.ReleasePage(source.AcquirePage(4096, 4096), 4096, 4096);
+  run_pages("pages", &source, "ObjectAllocator+huge", source.UsingReservedHugePages() ? "reserved=1" : "reserved=0",
+            objects, passes);
+}
+
+// Moves this thread onto Node's CPUs, returns false if it can't be moved
+static bool pin_to_node(unsigned Node)
+{
+#if defined(__linux__)
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", Node);
+  FILE* file = fopen(path, "r");
+  if (file == nullptr)
+    return false;
+
+  // Something like "0-7,16-23"
+  char line[1024];
+  bool read = fgets(line, sizeof(line), file) != nullptr;
+  fclose(file);
+  if (!read)
+    return false;
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (const char* c = line; *c >= '0' && *c <= '9'; )
+  {
+    unsigned first = 0;
+    while (*c >= '0' && *c <= '9')
+      first = first * 10 + (*c++ - '0');
+
+    unsigned last = first;
+    if (*c == '-')
+    {
+      last = 0;
+      for (++c; *c >= '0' && *c <= '9'; ++c)
+        last = last * 10 + (*c - '0');
+    }
+
+    for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+      CPU_SET(cpu, &cpus);
+
+    if (*c == ',')
+      ++c;
+  }
+
+  return CPU_COUNT(&cpus) > 0 && sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+  (void)Node;
+  return false;
+#endif
+}
+
+// Every CPU node against every memory node, so local and remote pages can be compared
+// With one node there is nothing remote, the single row says so and which path it fell back to
+static void suite_numa(void)
+{
+  const size_t objects = (1u << 20) / Scale;
+  const unsigned passes = 4;
+  const std::vector<unsigned>& nodes = NumaPageSource::GetNodes();
+
+  // A NumaObjectAllocator with one node is just one ObjectAllocator
+  {
+    NumaObjectAllocator router(64, OAConfig(false, 4096, 0));
+    fprintf(stderr, "numa: %zu node(s), NumaObjectAllocator made %u pool(s)\n", nodes.size(), router.GetNodeCount());
+  }
+
+  if (nodes.size() == 1)
+  {
+    NumaPageSource source(nodes[0]);
+    source.ReleasePage(source.AcquirePage(4096, 4096), 4096, 4096);
+
+    fprintf(stderr, "numa: single node, NumaPageSource falls back to plain mmap and nothing is remote\n");
+    run_pages("numa", &source, "ObjectAllocator+numa",
+              std::string("cpu_node=0;memory_node=0;local=1;bound=") + (source.IsBound() ? "1" : "0") +
+              ";fallback=single_node_mmap", objects, passes);
+    return;
+  }
+
+#if defined(__linux__)
+  // Put the thread back where it was when done
+  cpu_set_t original;
+  bool restore = sched_getaffinity(0, sizeof(original), &original) == 0;
+#endif
+
+  // Node IDs can have gaps, so go by the online list
+  for (size_t c = 0; c < nodes.size(); ++c)
+  {
+    unsigned cpuNode = nodes[c];
+    if (!pin_to_node(cpuNode))
+    {
+      fprintf(stderr, "numa: couldn't run on node %u, skipping it\n", cpuNode);
+      continue;
+    }
+
+    for (size_t m = 0; m < nodes.size(); ++m)
+    {
+      unsigned memoryNode = nodes[m];
+
+      // The binding only fails when the first region is mapped, so map one before naming the row
+      NumaPageSource source(memoryNode);
+      source.ReleasePage(source.AcquirePage(4096, 4096), 4096, 4096);
+
+      char notes[96];
+      snprintf(notes, sizeof(notes), "cpu_node=%u;memory_node=%u;local=%d;bound=%d", cpuNode, memoryNode,
+               cpuNode == memoryNode ? 1 : 0, source.IsBound() ? 1 : 0);
+      run_pages("numa", &source, "ObjectAllocator+numa", notes, objects, passes);
+    }
+  }
+
+#if defined(__linux__)
+  if (restore)
+    sched_setaffinity(0, sizeof(original), &original);
+#endif
+}
+
+// Every suite, in the order they run without arguments
+struct Suite
+{
+  const char *Name;
+  void (*Run)(void);
+};
+
+static const Suite SUITES[] =
+{
+  { "patterns", suite_patterns },  // LIFO, FIFO, random, bursty and producer/consumer against new and malloc
+  { "sweep", suite_sweep },        // the ObjectAllocator's config options against each other
+  { "lockfree", suite_lockfree },  // LockFree_ against a mutex, 1 to 64 threads
+  { "pmr", suite_pmr },            // std::list and std::map nodes against unsynchronized_pool_resource
+  { "pages", suite_pages },        // heap, 4K mmap and huge page sources, dTLB misses where perf allows
+  { "numa", suite_numa }           // local against remote node memory, or the single node fallback
+};
+
+static const size_t SUITE_COUNT = sizeof(SUITES) / sizeof(SUITES[0]);
+
+int main(int argc, char **argv)
+{
+  std::vector<const Suite*> run;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--quick") == 0)
+    {
+      Scale = 10;
+      continue;
+    }
+
+    const Suite* found = nullptr;
+    for (size_t s = 0; s < SUITE_COUNT; ++s)
+      if (strcmp(argv[i], SUITES[s].Name) == 0)
+        found = &SUITES[s];
+
+    if (found == nullptr)
+    {
+      fprintf(stderr, "usage: %s [--quick] [suite...]\nsuites:", argv[0]);
+      for (size_t s = 0; s < SUITE_COUNT; ++s)
+        fprintf(stderr, " %s", SUITES[s].Name);
+      fprintf(stderr, "\n");
+      return 1;
+    }
+
+    run.push_back(found);
+  }
+
+  // Nothing named, so run them all
+  if (run.empty())
+    for (size_t s = 0; s < SUITE_COUNT; ++s)
+      run.push_back(&SUITES[s]);
+
+  write_header();
+  for (size_t i = 0; i < run.size(); ++i)
+  {
+    fprintf(stderr, "running %s\n", run[i]->Name);
+    run[i]->Run();
+  }
+
+  return 0;
+}
@@ -0,0 +1,1061 @@
+/*!*************************************************************************************************
+\file    ObjectAllocatorTests.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds standalone checks for the allocators. Build it with the allocator sources,
+         g++ -std=c++17 -O2 -pthread ObjectAllocatorTests.cpp ObjectAllocator.cpp PageSource.cpp
+         SmallObjectAllocator.cpp AllocationProfiler.cpp HandleAllocator.cpp, then run it. It prints
+         every failed check and returns how many checks failed.
+***************************************************************************************************/
+
+#include "AllocationProfiler.h"    // AllocationProfiler
+#include "HandleAllocator.h"       // HandleAllocator
+#include "ObjectAllocator.h"       // ObjectAllocator, OAConfig, OAStats, OAException
+#include "PageSource.h"            // MmapPageSource, NumaPageSource
+#include "SmallObjectAllocator.h"  // SmallObjectAllocator
+#include "TypedObjectAllocator.h"  // TypedObjectAllocator, OAStaticConfig
+#include <algorithm>               // std::min, std::sort, std::adjacent_find, std::is_sorted
+#include <atomic>                  // std::atomic
+#include <cstddef>                 // std::max_align_t
+#include <cstdint>                 // std::uintptr_t
+#include <cstdio>                  // printf
+#include <cstring>                 // strcmp
+#include <thread>                  // std::thread
+#include <vector>                  // std::vector
+
+// Checks that failed so far
+static int Failures = 0;
+
+// Prints a failed check and counts it
+static void check(bool Passed, const char *What)
+{
+  if (Passed)
+    return;
+
+  printf("FAILED: %s\n", What);
+  ++Failures;
+}
+
+/***************************************************************************************************
+  Empty pages
+***************************************************************************************************/
+
+// Without DebugOn_ a foreign pointer is still rejected, and emptied pages are found and released
+static void test_release_free_finds_pages(void)
+{
+  ObjectAllocator oa(16, OAConfig(false, 4, 0));
+  ObjectAllocator other(16, OAConfig(false, 4, 0));
+
+  // Several pages, freed out of order so the lookups land all over the page index
+  std::vector<void*> objects;
+  for (unsigned i = 0; i < 32; ++i)
+    objects.push_back(oa.Allocate());
+
+  void* stranger = other.Allocate();
+  bool threw = false;
+  try
+  {
+    oa.Free(stranger);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_BAD_BOUNDARY;
+  }
+  check(threw, "a release free of another allocator's object is caught");
+  other.Free(stranger);
+
+  for (size_t i = 0; i < objects.size(); i += 2)
+    oa.Free(objects[i]);
+  for (size_t i = 1; i < objects.size(); i += 2)
+    oa.Free(objects[i]);
+
+  check(oa.FreeEmptyPages() == 8, "every emptied page is released");
+  check(oa.GetStats().PagesInUse_ == 0 && oa.GetStats().FreeObjects_ == 0, "nothing is left after the pages go");
+}
+
+/***************************************************************************************************
+  Page sources
+***************************************************************************************************/
+
+// Contains finds every page without the lock, even while another thread keeps mapping new regions
+static void test_page_source_contains(void)
+{
+  const size_t page = 4096;
+  MmapPageSource source(16 * page);
+
+  void* first = source.AcquirePage(page, page);
+  std::atomic<bool> done(false);
+  std::atomic<unsigned> misses(0);
+
+  // Asks about the first page the whole time the regions are growing
+  std::thread reader([&]()
+  {
+    while (!done.load())
+      if (!source.Contains(static_cast<char*>(first) + page - 1))
+        misses.fetch_add(1);
+  });
+
+  std::vector<void*> pages;
+  for (unsigned i = 0; i < 256; ++i)
+    pages.push_back(source.AcquirePage(page, page));
+
+  done.store(true);
+  reader.join();
+
+  bool all = true;
+  for (void* p : pages)
+    all = all && source.Contains(p) && source.Contains(static_cast<char*>(p) + page - 1);
+
+  int local = 0;
+  check(misses.load() == 0, "a page is found while new regions are mapped");
+  check(all, "every page in every region is found");
+  check(source.GetRegionCount() > 1, "the pages needed more than one region");
+  check(!source.Contains(&local), "an address outside the regions isn't found");
+
+  for (void* p : pages)
+    source.ReleasePage(p, page, page);
+  source.ReleasePage(first, page, page);
+
+  // Node IDs can have gaps, the count is how many are online
+  const std::vector<unsigned>& nodes = NumaPageSource::GetNodes();
+  check(!nodes.empty() && NumaPageSource::GetNodeCount() == nodes.size(), "the node count is the online node list");
+  check(std::is_sorted(nodes.begin(), nodes.end()), "the online nodes are in order");
+}
+
+/***************************************************************************************************
+  AllocationProfiler
+***************************************************************************************************/
+
+// A label is one site by its text, whatever buffer it's in, and a buffer reused for another label isn't
+static void test_profiler_labels_by_text(void)
+{
+  AllocationProfiler profiler(1);
+  int objects[4];
+
+  char first[16] = "mesh";
+  char second[16] = "mesh";
+  profiler.RecordAllocate(&objects[0], 16, first, nullptr);
+  profiler.RecordAllocate(&objects[1], 16, second, nullptr);
+  check(profiler.GetSiteCount() == 1, "the same label in two buffers is one site");
+
+  snprintf(first, sizeof(first), "texture");
+  profiler.RecordAllocate(&objects[2], 16, first, nullptr);
+  check(profiler.GetSiteCount() == 2, "a reused label buffer with new text is a new site");
+
+  profiler.RecordAllocate(&objects[3], 16, nullptr, &objects);
+  check(profiler.GetSiteCount() == 3, "a call site without a label is its own site");
+
+  // Resetting while another thread records, the clock's start is read without the lock
+  std::thread resetter([&]()
+  {
+    for (int i = 0; i < 1000; ++i)
+      profiler.Reset();
+  });
+  for (int i = 0; i < 1000; ++i)
+  {
+    profiler.RecordAllocate(&objects[i % 4], 16, "reset", nullptr);
+    profiler.RecordFree(&objects[i % 4]);
+  }
+  resetter.join();
+
+  profiler.Reset();
+  check(profiler.GetSiteCount() == 0 && profiler.GetLiveSamples() == 0, "Reset forgets every site and sample");
+
+  // A bulk release only forgets the samples on the pages it names, the profiler can be shared
+  char pages[3][64];
+  const char* released[] = { pages[0], pages[2] };
+  profiler.RecordAllocate(pages[0] + 8, 8, "bulk", nullptr);
+  profiler.RecordAllocate(pages[1] + 8, 8, "bulk", nullptr);
+  profiler.RecordAllocate(pages[2] + 63, 8, "bulk", nullptr);
+  profiler.RecordFreeAll(released, 2, 64);
+  check(profiler.GetLiveSamples() == 1, "a bulk release frees the samples on its pages and no others");
+}
+
+/***************************************************************************************************
+  Region mode
+***************************************************************************************************/
+
+// Reset takes every object back and keeps the pages, a stale free afterwards changes nothing
+static void test_region_reset(void)
+{
+  OAConfig config(false, 8, 0);
+  config.Region_ = true;
+  ObjectAllocator oa(16, config);
+
+  std::vector<void*> objects;
+  for (unsigned i = 0; i < 20; ++i)
+    objects.push_back(oa.Allocate());
+  for (unsigned i = 0; i < 5; ++i)
+    oa.Free(objects[i]);
+
+  OAStats before = oa.GetStats();
+  check(before.Deallocations_ == 5 && before.ObjectsInUse_ == 15, "region frees are counted");
+
+  oa.Reset();
+  OAStats after = oa.GetStats();
+  check(after.ObjectsInUse_ == 0, "Reset takes every object back");
+  check(after.PagesInUse_ == before.PagesInUse_, "Reset keeps the pages");
+  check(after.FreeObjects_ == after.PagesInUse_ * config.ObjectsPerPage_, "every block is free after Reset");
+  check(oa.GetTelemetry().ObjectsInUse_ == 0, "the telemetry sees the objects come back");
+
+  // From before the Reset, so it's ignored and not counted
+  std::uint64_t telemetryFrees = oa.GetTelemetry().Deallocations_;
+  oa.Free(objects[10]);
+  check(oa.GetStats().Deallocations_ == 5, "a stale free isn't counted");
+  check(oa.GetTelemetry().Deallocations_ == telemetryFrees, "a stale free isn't in the telemetry either");
+  check(oa.GetStats().ObjectsInUse_ == 0, "a stale free doesn't change what's in use");
+
+  // The next cycle starts over on the same pages
+  check(oa.Allocate() == objects[0], "the next cycle starts at the first object again");
+  check(oa.GetStats().PagesInUse_ == before.PagesInUse_, "the next cycle needs no new pages");
+}
+
+/***************************************************************************************************
+  HandleAllocator
+***************************************************************************************************/
+
+// Compact packs the live objects onto the fewest pages, every handle still finds its value
+static void test_handle_compact(void)
+{
+  HandleAllocator handles(sizeof(std::uint64_t), OAConfig(false, 8, 0, true));
+
+  std::vector<HandleAllocator::Handle> live;
+  for (std::uint64_t i = 0; i < 64; ++i)
+  {
+    HandleAllocator::Handle handle = handles.Allocate();
+    *static_cast<std::uint64_t*>(handles.Get(handle)) = i;
+
+    // Three out of four go again, so every page ends up mostly empty
+    if (i % 4 == 0)
+      live.push_back(handle);
+    else
+      handles.Free(handle);
+  }
+
+  unsigned before = handles.GetStats().PagesInUse_;
+  unsigned freed = handles.Compact();
+  OAStats stats = handles.GetStats();
+
+  check(freed == before - 2 && stats.PagesInUse_ == 2, "Compact packs 16 objects onto 2 pages and releases the rest");
+  check(stats.ObjectsInUse_ == live.size() && handles.GetHandleCount() == live.size(), "Compact keeps every live object");
+
+  bool kept = true;
+  for (size_t i = 0; i < live.size(); ++i)
+  {
+    std::uint64_t* value = static_cast<std::uint64_t*>(handles.Get(live[i]));
+    kept = kept && value != nullptr && *value == i * 4;
+  }
+  check(kept, "every handle finds its own value after Compact");
+
+  // The moved objects free like any other, and the allocator can grow again afterwards
+  for (size_t i = 0; i < live.size(); ++i)
+    handles.Free(live[i]);
+  check(handles.GetStats().ObjectsInUse_ == 0, "moved objects free normally");
+  handles.Free(handles.Allocate());
+}
+
+// A freed handle stays stale however many times its slot is reused
+static void test_stale_handles(void)
+{
+  HandleAllocator handles(16, OAConfig(false, 8, 0));
+
+  HandleAllocator::Handle first = handles.Allocate();
+  handles.Free(first);
+  check(handles.Get(first) == nullptr, "a freed handle finds nothing");
+
+  bool threw = false;
+  try
+  {
+    handles.Free(first);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_MULTIPLE_FREE;
+  }
+  check(threw, "freeing a handle twice is caught");
+
+  // Well past what an 8 bit generation could tell apart
+  bool stale = true;
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    HandleAllocator::Handle reuse = handles.Allocate();
+    stale = stale && reuse != first && (reuse & HandleAllocator::INDEX_MASK) == (first & HandleAllocator::INDEX_MASK);
+    stale = stale && handles.Get(first) == nullptr;
+    handles.Free(reuse);
+  }
+  check(stale, "the slot is reused and the old handle never matches it");
+
+  threw = false;
+  try
+  {
+    handles.Free(HandleAllocator::NULL_HANDLE);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_BAD_BOUNDARY;
+  }
+  check(threw, "freeing the null handle is caught");
+}
+
+/***************************************************************************************************
+  Thread caches
+***************************************************************************************************/
+
+// Objects waiting to be freed by the next thread over
+static std::atomic<void*> CacheMailboxes[4];
+
+// Every thread allocates, frees some itself and passes one to the next thread to free
+static void trade_cached_objects(ObjectAllocator *OA, unsigned Thread)
+{
+  for (unsigned round = 0; round < 2000; ++round)
+  {
+    void* objects[4];
+    for (unsigned i = 0; i < 4; ++i)
+      objects[i] = OA->Allocate();
+
+    // Freed by a thread that didn't allocate it, so it lands in the wrong magazine
+    if (void* theirs = CacheMailboxes[(Thread + 1) % 4].exchange(objects[0]))
+      OA->Free(theirs);
+
+    for (unsigned i = 1; i < 4; ++i)
+      OA->Free(objects[i]);
+  }
+}
+
+// Cross-thread frees, a thread leaving with a full magazine, and the allocator going before its threads
+static void test_thread_cache_threads(void)
+{
+  OAConfig config(false, 16, 0);
+  config.ThreadCacheSize_ = 8;
+  ObjectAllocator* oa = new ObjectAllocator(32, config);
+
+  // Threads trading objects, the stats have to add up once they're done
+  for (unsigned i = 0; i < 4; ++i)
+    CacheMailboxes[i].store(nullptr);
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < 4; ++i)
+    threads.emplace_back(trade_cached_objects, oa, i);
+  for (std::thread& thread : threads)
+    thread.join();
+  for (unsigned i = 0; i < 4; ++i)
+    if (void* object = CacheMailboxes[i].exchange(nullptr))
+      oa->Free(object);
+
+  OAStats stats = oa->GetStats();
+  check(stats.Allocations_ == 4 * 2000 * 4 && stats.Deallocations_ == stats.Allocations_, "every cached request is counted");
+  check(stats.ObjectsInUse_ == 0, "nothing is in use after the threads traded and freed everything");
+  check(stats.FreeObjects_ == stats.PagesInUse_ * config.ObjectsPerPage_, "every cached object is counted as free");
+
+  // A thread that leaves with objects in its magazine gives them back on the way out
+  std::vector<void*> kept;
+  std::thread leaver([&]()
+  {
+    for (unsigned i = 0; i < 10; ++i)
+      kept.push_back(oa->Allocate());
+    for (unsigned i = 0; i < 6; ++i)
+    {
+      oa->Free(kept.back());
+      kept.pop_back();
+    }
+  });
+  leaver.join();
+
+  stats = oa->GetStats();
+  check(stats.ObjectsInUse_ == 4, "an exited thread's magazine isn't counted as in use");
+  check(stats.FreeObjects_ + stats.ObjectsInUse_ == stats.PagesInUse_ * config.ObjectsPerPage_,
+        "free and in use objects add up to the pages after a thread exits");
+
+  // Its objects can still be freed from another thread
+  for (void* object : kept)
+    oa->Free(object);
+  check(oa->GetStats().ObjectsInUse_ == 0, "objects from an exited thread free normally");
+
+  // A thread still holding a magazine when the allocator is destroyed
+  std::atomic<int> stage(0);
+  std::thread lingerer([&]()
+  {
+    oa->Free(oa->Allocate());
+    stage.store(1);
+    while (stage.load() != 2)
+      std::this_thread::yield();
+  });
+
+  while (stage.load() != 1)
+    std::this_thread::yield();
+  delete oa;
+
+  // A new allocator can land at the same address, the exiting thread mustn't mistake it for the old one
+  ObjectAllocator* replacement = new ObjectAllocator(32, config);
+  stage.store(2);
+  lingerer.join();
+
+  stats = replacement->GetStats();
+  check(stats.ObjectsInUse_ == 0 && stats.FreeObjects_ == stats.PagesInUse_ * config.ObjectsPerPage_,
+        "a thread exiting after its allocator is gone leaves other allocators alone");
+  delete replacement;
+}
+
+/***************************************************************************************************
+  Batches
+***************************************************************************************************/
+
+// A batch that needs a new page, one that runs out of pages partway, and the stats after FreeBatch
+static void test_batches(void)
+{
+  // Batched in one go, and one at a time because the headers need it
+  const OAConfig configs[] =
+  {
+    OAConfig(false, 4, 3, true),
+    OAConfig(false, 4, 3, true, 0, OAConfig::HeaderBlockInfo(OAConfig::hbBasic))
+  };
+
+  for (const OAConfig& config : configs)
+  {
+    ObjectAllocator oa(16, config);
+    void* objects[12];
+
+    // Three on the first page, then five more that only fit once a second page is made
+    oa.AllocateBatch(objects, 3);
+    oa.AllocateBatch(objects + 3, 5);
+    OAStats stats = oa.GetStats();
+    check(stats.PagesInUse_ == 2 && stats.ObjectsInUse_ == 8 && stats.FreeObjects_ == 0, "a batch spans a new page");
+
+    // Eight more would need a fourth page, so none of them are handed out
+    void* tooMany[8];
+    bool threw = false;
+    try
+    {
+      oa.AllocateBatch(tooMany, 8);
+    }
+    catch (OAException &e)
+    {
+      threw = e.code() == OAException::E_NO_PAGES;
+    }
+    stats = oa.GetStats();
+    check(threw, "a batch past MaxPages_ is reported");
+    // A rolled back batch counts what it gave back as freed, so only the difference has to hold
+    check(stats.ObjectsInUse_ == 8 && stats.Allocations_ - stats.Deallocations_ == 8,
+          "a batch past MaxPages_ hands out nothing");
+    check(stats.FreeObjects_ + stats.ObjectsInUse_ == stats.PagesInUse_ * config.ObjectsPerPage_,
+          "the stats add up after a failed batch");
+
+    // What's left still fits, and every object is different
+    oa.AllocateBatch(objects + 8, 4);
+    std::vector<void*> sorted(objects, objects + 12);
+    std::sort(sorted.begin(), sorted.end());
+    check(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end(), "a batch never repeats an object");
+
+    const unsigned freedBefore = oa.GetStats().Deallocations_;
+    oa.FreeBatch(objects, 12);
+    stats = oa.GetStats();
+    check(stats.ObjectsInUse_ == 0 && stats.Deallocations_ - freedBefore == 12, "FreeBatch counts every object");
+    check(stats.FreeObjects_ == 12 && stats.PagesInUse_ == 3, "FreeBatch puts every object back on the free list");
+  }
+}
+
+/***************************************************************************************************
+  Fullest page first
+***************************************************************************************************/
+
+// True if Object is between the first and last objects of a page
+static bool on_page(const void* Object, void* const* Page, unsigned ObjectsPerPage)
+{
+  return Object >= Page[0] && Object <= Page[ObjectsPerPage - 1];
+}
+
+// Allocate fills the fullest page that has room, and a page that empties out is released
+static void test_fullest_page_policy(void)
+{
+  // Eight objects a page puts every live count in its own bin
+  const unsigned perPage = 8;
+  OAConfig config(false, perPage, 3);
+  config.Policy_ = OAConfig::apFullestPage;
+  config.EmptyPageThreshold_ = 0.25f;
+  ObjectAllocator oa(16, config);
+
+  // Fill three pages, in address order a page's objects sit together
+  void* objects[3 * perPage];
+  for (unsigned i = 0; i < 3 * perPage; ++i)
+    objects[i] = oa.Allocate();
+  std::sort(objects, objects + 3 * perPage);
+  void** fullest = objects;
+  void** emptiest = objects + perPage;
+  void** middle = objects + 2 * perPage;
+
+  // Leave six, two and four objects out on the three pages
+  for (unsigned i = 0; i < 2; ++i)
+    oa.Free(fullest[i]);
+  for (unsigned i = 0; i < 6; ++i)
+    oa.Free(emptiest[i]);
+  for (unsigned i = 0; i < 4; ++i)
+    oa.Free(middle[i]);
+
+  // The next two go on the fullest page, then it's full and the middle one is next
+  bool fillsFullest = true;
+  for (unsigned i = 0; i < 2; ++i)
+    fillsFullest = on_page(fullest[i] = oa.Allocate(), fullest, perPage) && fillsFullest;
+  check(fillsFullest, "allocations go to the fullest page with room");
+  middle[0] = oa.Allocate();
+  check(on_page(middle[0], middle, perPage), "a full page is skipped for the next fullest one");
+
+  // Emptying the emptiest page leaves too much free, so it goes back
+  for (unsigned i = 6; i < perPage; ++i)
+    oa.Free(emptiest[i]);
+  OAStats stats = oa.GetStats();
+  check(stats.PagesInUse_ == 2 && stats.FreeObjects_ == 3, "an empty page is released past the threshold");
+  check(stats.Fragmentation_ > 0.18f && stats.Fragmentation_ < 0.19f, "the holes left are fragmentation");
+}
+
+/***************************************************************************************************
+  Side table headers
+***************************************************************************************************/
+
+// Blocks are just object and pads, labels are copied once and shared by text
+static void test_side_table_headers(void)
+{
+  OAConfig config(false, 4, 0, true, 2, OAConfig::HeaderBlockInfo(OAConfig::hbExternal));
+  config.HeaderLayout_ = OAConfig::hlSideTable;
+  ObjectAllocator oa(16, config);
+
+  // Two copies of the same text, the second one gets rewritten later
+  char first[] = "alpha";
+  char second[] = "alpha";
+  void* objects[4];
+  objects[0] = oa.Allocate(first);
+  objects[1] = oa.Allocate(second);
+  objects[2] = oa.Allocate("beta");
+  objects[3] = oa.Allocate();
+
+  // Nothing but the pads between objects on a page
+  std::vector<void*> sorted(objects, objects + 4);
+  std::sort(sorted.begin(), sorted.end());
+  bool packed = true;
+  for (int i = 1; i < 4; ++i)
+    packed = packed && static_cast<char*>(sorted[i]) - static_cast<char*>(sorted[i - 1]) == 16 + 2 * 2;
+  check(packed, "side table blocks are only the object and its pads");
+
+  OAHeader headers[4];
+  for (int i = 0; i < 4; ++i)
+    oa.GetHeader(objects[i], headers[i]);
+  second[0] = 'o';
+  check(headers[0].Label == headers[1].Label && headers[0].Label != first, "labels are interned by their text");
+  check(strcmp(headers[1].Label, "alpha") == 0 && strcmp(headers[2].Label, "beta") == 0,
+        "interned labels keep their text after the client's copy changes");
+  check(headers[3].Label == nullptr, "no label is recorded as none");
+  check(headers[0].InUse && headers[0].AllocNum == 1 && headers[3].AllocNum == 4, "side table headers are filled in");
+
+  // The pads are still checked, the header isn't in the way
+  bool threw = false;
+  static_cast<unsigned char*>(objects[2])[16] = 0;
+  try
+  {
+    oa.Free(objects[2]);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_CORRUPTED_BLOCK;
+  }
+  check(threw, "a side table block's pad is checked");
+  static_cast<unsigned char*>(objects[2])[16] = ObjectAllocator::PAD_PATTERN;
+
+  for (int i = 0; i < 4; ++i)
+    oa.Free(objects[i]);
+  oa.GetHeader(objects[0], headers[0]);
+  check(!headers[0].InUse, "a freed block's side table entry is cleared");
+
+  // Extended headers count each time a block is reused
+  OAConfig extended(false, 4, 0, false, 0, OAConfig::HeaderBlockInfo(OAConfig::hbExtended, 4));
+  extended.HeaderLayout_ = OAConfig::hlSideTable;
+  ObjectAllocator reused(16, extended);
+  void* object = reused.Allocate();
+  reused.Free(object);
+  void* again = reused.Allocate();
+  OAHeader header;
+  reused.GetHeader(again, header);
+  check(again == object && header.UseCount == 2 && header.AllocNum == 2, "side table use counts follow reuse");
+  check(header.UserData != nullptr, "extended side table headers have user bytes");
+  reused.Free(again);
+}
+
+/***************************************************************************************************
+  System heap
+***************************************************************************************************/
+
+// Counts the blocks a walk reports
+static unsigned SystemHeapReports = 0;
+
+// Counts a reported block
+static void count_report(const void *, size_t)
+{
+  ++SystemHeapReports;
+}
+
+// The checked system heap back end catches what a page would and keeps the usual stats
+static void test_checked_system_heap(void)
+{
+  ObjectAllocator oa(24, OAConfig(true, 8, 0, true, 4));
+
+  void* objects[3];
+  for (int i = 0; i < 3; ++i)
+    objects[i] = oa.Allocate();
+  oa.Free(objects[1]);
+
+  // No pages, nothing free, the rest counts like it does on pages
+  OAStats stats = oa.GetStats();
+  check(stats.PagesInUse_ == 0 && stats.FreeObjects_ == 0, "the system heap has no pages or free objects");
+  check(stats.ObjectsInUse_ == 2 && stats.MostObjects_ == 3 && stats.Allocations_ == 3 && stats.Deallocations_ == 1,
+        "the system heap keeps the usual counts");
+  check(oa.Owns(objects[0]) && !oa.Owns(objects[1]), "only tracked system heap objects are owned");
+
+  // Freed twice, and never ours
+  bool threw = false;
+  try
+  {
+    oa.Free(objects[1]);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_BAD_BOUNDARY;
+  }
+  check(threw, "a system heap double free is caught");
+
+  long stranger = 0;
+  threw = false;
+  try
+  {
+    oa.Free(&stranger);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_BAD_BOUNDARY;
+  }
+  check(threw, "freeing a pointer the system heap never gave out is caught");
+
+  // A pad written over is found by Free and by ValidatePages
+  static_cast<unsigned char*>(objects[2])[24] = 0;
+  SystemHeapReports = 0;
+  check(oa.ValidatePages(count_report) == 1 && SystemHeapReports == 1, "ValidatePages finds a bad system heap pad");
+  threw = false;
+  try
+  {
+    oa.Free(objects[2]);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_CORRUPTED_BLOCK;
+  }
+  check(threw, "a bad system heap pad is caught on Free");
+  static_cast<unsigned char*>(objects[2])[24] = ObjectAllocator::PAD_PATTERN;
+
+  SystemHeapReports = 0;
+  check(oa.DumpMemoryInUse(count_report) == 2 && SystemHeapReports == 2, "DumpMemoryInUse walks the system heap");
+  oa.Free(objects[2]);
+
+  // Over-aligned objects use the aligned new and delete, objects[0] is left for the destructor
+  ObjectAllocator aligned(24, OAConfig(true, 8, 0, false, 0, OAConfig::HeaderBlockInfo(), 64));
+  void* object = aligned.Allocate();
+  check(reinterpret_cast<std::uintptr_t>(object) % 64 == 0, "system heap objects get Alignment_");
+  aligned.Free(object);
+}
+
+/***************************************************************************************************
+  SmallObjectAllocator
+***************************************************************************************************/
+
+// Sizes a pool covers have to land in that pool, the power of two ones used to go to the system
+static void test_small_sizes_use_pools(void)
+{
+  const size_t sizes[] = { 1, 8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024 };
+  const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+
+  SmallObjectAllocator soa;
+  void* objects[count];
+
+  for (size_t i = 0; i < count; ++i)
+    objects[i] = soa.Allocate(sizes[i]);
+
+  check(soa.GetLargeAllocations() == 0, "sizes up to MAX_SMALL_SIZE are not counted as large");
+
+  // Every object is aligned as much as malloc would align something that size
+  for (size_t i = 0; i < count; ++i)
+  {
+    size_t alignment = std::min<size_t>(sizes[i] & (~sizes[i] + 1), alignof(std::max_align_t));
+    check(reinterpret_cast<std::uintptr_t>(objects[i]) % alignment == 0, "small objects get malloc's alignment");
+  }
+
+  // Half go back with their size, half without, both have to find the pool
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (i % 2 == 0)
+      soa.Free(objects[i], sizes[i]);
+    else
+      soa.Free(objects[i]);
+  }
+
+  unsigned inUse = 0;
+  for (unsigned c = 0; c < SmallObjectAllocator::CLASS_COUNT; ++c)
+    inUse += soa.GetStats(c).ObjectsInUse_;
+  check(inUse == 0, "small objects go back to their pools");
+
+  // Too big for any pool is still large
+  void* large = soa.Allocate(SmallObjectAllocator::MAX_SMALL_SIZE + 1);
+  check(soa.GetLargeAllocations() == 1, "sizes over MAX_SMALL_SIZE are counted as large");
+  soa.Free(large, SmallObjectAllocator::MAX_SMALL_SIZE + 1);
+}
+
+// Free without a size finds pages made and released along the way, and the system heap pools still work
+static void test_unsized_free_finds_pages(void)
+{
+  OAConfig config(false, DEFAULT_OBJECTS_PER_PAGE, 0);
+  config.EmptyPageThreshold_ = 0.5f;
+  SmallObjectAllocator soa(config);
+
+  // Plenty of pages in one class, all of them given back without a size
+  std::vector<void*> objects;
+  for (int i = 0; i < 2000; ++i)
+    objects.push_back(soa.Allocate(64));
+  for (size_t i = 0; i < objects.size(); ++i)
+    soa.Free(objects[i]);
+  OAStats stats = soa.GetStats(5);
+  check(stats.ObjectsInUse_ == 0 && stats.Deallocations_ == 2000, "Free without a size finds every page");
+  check(stats.PagesInUse_ < 8, "pages are released while they're looked up by address");
+
+  // The heap may reuse a released page for this, it mustn't look like the pool's
+  void* large = soa.Allocate(SmallObjectAllocator::MAX_SMALL_SIZE * 4);
+  soa.Free(large);
+  check(soa.GetLargeAllocations() == 1, "large objects go back to the system without a size");
+
+  // No pages to look up, the tracked objects are found instead
+  SmallObjectAllocator system(OAConfig(true, 8, 0, true));
+  void* object = system.Allocate(100);
+  system.Free(object);
+  check(system.GetStats(7).ObjectsInUse_ == 0, "Free without a size works on the system heap");
+}
+
+/***************************************************************************************************
+  ForEachLive
+***************************************************************************************************/
+
+// The system heap has no pages, so the objects debug mode tracks are what gets walked
+static void test_for_each_live_system_heap(void)
+{
+  ObjectAllocator oa(24, OAConfig(true, 8, 0, true));
+
+  void* objects[5];
+  for (int i = 0; i < 5; ++i)
+    objects[i] = oa.Allocate();
+  oa.Free(objects[2]);
+
+  std::vector<void*> visited;
+  unsigned count = oa.ForEachLive([&visited](void *Object) { visited.push_back(Object); });
+
+  std::vector<void*> expected;
+  for (int i = 0; i < 5; ++i)
+    if (i != 2)
+      expected.push_back(objects[i]);
+  std::sort(expected.begin(), expected.end());
+
+  check(count == 4 && visited == expected, "ForEachLive walks tracked system heap objects in address order");
+
+  for (int i = 0; i < 5; ++i)
+    if (i != 2)
+      oa.Free(objects[i]);
+}
+
+/***************************************************************************************************
+  TypedObjectAllocator
+***************************************************************************************************/
+
+// Debug checks find a block's page in the sorted index, whichever page it's on
+static void test_typed_debug_pages(void)
+{
+  typedef TypedObjectAllocator<long, OAStaticConfig<4, 0, true, 8> > Allocator;
+  Allocator typed;
+  Allocator other;
+
+  // Enough for a lot of pages, destroyed out of order so every page is looked up
+  std::vector<long*> objects;
+  for (long i = 0; i < 400; ++i)
+    objects.push_back(typed.create(i));
+
+  bool threw = false;
+  for (size_t i = 0; i < objects.size(); i += 2)
+    typed.destroy(objects[i]);
+  for (size_t i = 1; i < objects.size(); i += 2)
+    typed.destroy(objects[i]);
+  check(typed.GetStats().ObjectsInUse_ == 0, "every typed object is destroyed");
+
+  // Freed already
+  try
+  {
+    typed.destroy(objects[123]);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_MULTIPLE_FREE;
+  }
+  check(threw, "destroying a typed object twice is caught");
+
+  // Not on any of this allocator's pages
+  long* stranger = other.create(0L);
+  threw = false;
+  try
+  {
+    typed.destroy(stranger);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_BAD_BOUNDARY;
+  }
+  check(threw, "destroying another allocator's object is caught");
+  other.destroy(stranger);
+}
+
+/***************************************************************************************************
+  Quarantine
+***************************************************************************************************/
+
+// What the UseAfterFree_ callback was last told
+static const void *ReportedObject = nullptr;
+static unsigned Reports = 0;
+
+// Remembers a use after free instead of printing it
+static void remember_use_after_free(const void *Object, size_t)
+{
+  ReportedObject = Object;
+  ++Reports;
+}
+
+// Pushing a written object out of the quarantine reports it, the Free that pushed it out succeeds
+static void test_quarantine_reports_evicted_object(void)
+{
+  OAConfig config(false, 8, 0, true);
+  config.QuarantineSize_ = 1;
+  config.UseAfterFree_ = remember_use_after_free;
+  ObjectAllocator oa(32, config);
+
+  ReportedObject = nullptr;
+  Reports = 0;
+
+  void* first = oa.Allocate();
+  void* second = oa.Allocate();
+  oa.Free(first);
+
+  // Written to while in quarantine, so it's reported when second pushes it out
+  static_cast<char*>(first)[0] = 0;
+
+  bool threw = false;
+  try
+  {
+    oa.Free(second);
+  }
+  catch (OAException&)
+  {
+    threw = true;
+  }
+
+  check(!threw, "Free doesn't throw about an object it wasn't given");
+  check(Reports == 1 && ReportedObject == first, "the evicted object is the one reported");
+  check(oa.GetStats().ObjectsInUse_ == 0, "both objects are released");
+
+  // A second free of the object that was just freed is still caught
+  threw = false;
+  try
+  {
+    oa.Free(second);
+  }
+  catch (OAException&)
+  {
+    threw = true;
+  }
+  check(threw, "freeing the quarantined object again is a double free");
+
+  // The telemetry counts the free that did the reporting
+  check(oa.GetTelemetry().ObjectsInUse_ == 0, "telemetry counts a free that reported a use after free");
+  check(oa.GetTelemetry().Deallocations_ == 2, "telemetry counts both frees");
+}
+
+// A page empties when its last quarantined object leaves, and the empty page policy sees it then
+static void test_quarantine_releases_empty_pages(void)
+{
+  OAConfig config(false, 4, 0);
+  config.QuarantineSize_ = 2;
+  config.EmptyPageThreshold_ = 0.25f;
+  ObjectAllocator oa(32, config);
+
+  // Two pages, in address order a page's objects sit together
+  void* objects[8];
+  for (int i = 0; i < 8; ++i)
+    objects[i] = oa.Allocate();
+  std::sort(objects, objects + 8);
+
+  // The last two of the second page are still in quarantine
+  for (int i = 4; i < 8; ++i)
+    oa.Free(objects[i]);
+  oa.Free(objects[0]);
+  check(oa.GetStats().PagesInUse_ == 2, "a page with a quarantined object is kept");
+
+  // Pushing out the last one empties the page, and too much is free
+  oa.Free(objects[1]);
+  OAStats stats = oa.GetStats();
+  check(stats.PagesInUse_ == 1 && stats.FreeObjects_ == 0, "a page emptied by the quarantine is released");
+
+  oa.Free(objects[2]);
+  oa.Free(objects[3]);
+  oa.FlushQuarantine();
+}
+
+/***************************************************************************************************
+  Lock-free free list
+***************************************************************************************************/
+
+// Threads hammering one lock-free allocator, and how hard
+static const unsigned STRESS_THREADS = 8;
+static const unsigned STRESS_ROUNDS = 20000;
+static const unsigned STRESS_BATCH = 4;
+
+// Objects handed from one thread to another, so pages are shared and objects are freed by a stranger
+static std::atomic<void*> Mailboxes[STRESS_THREADS];
+
+// Objects found holding another thread's stamp, so the list gave one object out twice
+static std::atomic<unsigned> Duplicates(0);
+
+// Pops and pushes as fast as it can, which is what makes the ABA case (pop A, pop B, push A) happen
+static void stress_lock_free(ObjectAllocator *OA, unsigned Thread)
+{
+  void* batch[STRESS_BATCH];
+
+  for (unsigned round = 0; round < STRESS_ROUNDS; ++round)
+  {
+    // The first word is the list link, so stamp the second
+    for (unsigned i = 0; i < STRESS_BATCH; ++i)
+    {
+      batch[i] = OA->Allocate();
+      static_cast<std::uintptr_t*>(batch[i])[1] = (std::uintptr_t(Thread) << 32) | (round * STRESS_BATCH + i);
+    }
+
+    // Give someone else's thread a chance to touch the same objects
+    if (round % 64 == 0)
+      std::this_thread::yield();
+
+    for (unsigned i = 0; i < STRESS_BATCH; ++i)
+      if (static_cast<std::uintptr_t*>(batch[i])[1] != ((std::uintptr_t(Thread) << 32) | (round * STRESS_BATCH + i)))
+        Duplicates.fetch_add(1, std::memory_order_relaxed);
+
+    // Swap one object with the next thread, free whatever was waiting there
+    void* theirs = Mailboxes[(Thread + 1) % STRESS_THREADS].exchange(batch[0]);
+    if (theirs != nullptr)
+      OA->Free(theirs);
+
+    // The rest go back in reverse, so the head keeps going back to an object that was just popped
+    for (unsigned i = STRESS_BATCH - 1; i > 0; --i)
+      OA->Free(batch[i]);
+  }
+}
+
+// Many threads allocating and freeing on the same pages can't lose, duplicate or leak an object
+static void test_lock_free_stress(void)
+{
+  OAConfig config(false, 4, 0);
+  config.LockFree_ = true;
+  ObjectAllocator oa(2 * sizeof(std::uintptr_t), config);
+
+  for (unsigned i = 0; i < STRESS_THREADS; ++i)
+    Mailboxes[i].store(nullptr);
+  Duplicates.store(0);
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < STRESS_THREADS; ++i)
+    threads.emplace_back(stress_lock_free, &oa, i);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  // Whatever is still in a mailbox was never freed
+  for (unsigned i = 0; i < STRESS_THREADS; ++i)
+    if (void* object = Mailboxes[i].exchange(nullptr))
+      oa.Free(object);
+
+  OAStats stats = oa.GetStats();
+  check(Duplicates.load() == 0, "no object is given to two threads at once");
+  check(stats.Allocations_ == STRESS_THREADS * STRESS_ROUNDS * STRESS_BATCH, "every lock-free allocation is counted");
+  check(stats.Deallocations_ == stats.Allocations_, "every lock-free free is counted");
+  check(stats.ObjectsInUse_ == 0, "nothing is in use after every thread freed its objects");
+
+  // A corrupted list would hand out an object twice, or need a new page, before it ran dry
+  unsigned capacity = stats.PagesInUse_ * config.ObjectsPerPage_;
+  std::vector<void*> objects;
+  for (unsigned i = 0; i < capacity; ++i)
+    objects.push_back(oa.Allocate());
+
+  check(oa.GetStats().PagesInUse_ == stats.PagesInUse_, "every object on the free pages is still on the list");
+  std::sort(objects.begin(), objects.end());
+  check(std::adjacent_find(objects.begin(), objects.end()) == objects.end(), "the list holds every object once");
+
+  for (void* object : objects)
+    oa.Free(object);
+}
+
+// Hands out one page at an address a 48-bit pointer can't reach, never touched, and remembers it coming back
+class HighPageSource : public PageSource
+{
+  public:
+
+    void *AcquirePage(size_t, size_t) override { return reinterpret_cast<void*>(std::uintptr_t(1) << 48); }
+    void ReleasePage(void *Page, size_t, size_t) override { Released_ = Page; }
+
+    void *Released_ = nullptr;  // the last page given back
+};
+
+// A page the tagged list head can't hold is given back instead of being put on the list
+static void test_lock_free_high_pages(void)
+{
+  // Every address fits on 32-bit
+  if (sizeof(void*) != 8)
+    return;
+
+  HighPageSource source;
+  OAConfig config(false, 4, 0);
+  config.LockFree_ = true;
+  config.PageSource_ = &source;
+
+  bool threw = false;
+  try
+  {
+    ObjectAllocator oa(16, config);
+  }
+  catch (OAException &e)
+  {
+    threw = e.code() == OAException::E_NO_MEMORY;
+  }
+  check(threw, "a page above the lock-free tag is turned down");
+  check(source.Released_ == reinterpret_cast<void*>(std::uintptr_t(1) << 48), "a turned down page goes back to its source");
+}
+
+int main(void)
+{
+  test_release_free_finds_pages();
+  test_page_source_contains();
+  test_profiler_labels_by_text();
+  test_region_reset();
+  test_handle_compact();
+  test_stale_handles();
+  test_thread_cache_threads();
+  test_batches();
+  test_fullest_page_policy();
+  test_side_table_headers();
+  test_checked_system_heap();
+  test_small_sizes_use_pools();
+  test_unsized_free_finds_pages();
+  test_for_each_live_system_heap();
+  test_typed_debug_pages();
+  test_quarantine_reports_evicted_object();
+  test_quarantine_releases_empty_pages();
+  test_lock_free_stress();
+  test_lock_free_high_pages();
+
+  if (Failures == 0)
+    printf("All checks passed\n");
+
+  return Failures;
+}
@@ -0,0 +1,445 @@
+/////////////////////////////
+// PATHFINDING BENCHMARK
+/////////////////////////////
+
+// Times neighbor expansion with the old per-cell bool struct and std::list against the NeighborMask
+// and inline array AStarPather uses now. P2_Pathfinding.cpp only builds inside the engine, so the
+// grid, nodes and preprocessing are copied here as they are there, without the terrain or the
+// request. Build and run it on its own:
+//   g++ -std=c++17 -O2 P2_PathfindingBench.cpp -o P2_PathfindingBench && ./P2_PathfindingBench
+// Every result is one CSV row, and it fails if the two ever give different neighbors or paths.
+
+#include <algorithm>  // std::min, std::max
+#include <array>      // std::array
+#include <chrono>     // std::chrono::steady_clock
+#include <climits>    // SHRT_MAX
+#include <cstdio>     // printf, fprintf
+#include <cstdlib>    // abs
+#include <cstring>    // strcmp
+#include <list>       // std::list
+#include <queue>      // std::priority_queue
+#include <random>     // std::mt19937
+#include <vector>     // std::vector
+
+/////////////////////////////
+// DEFINES AND STATICS
+/////////////////////////////
+
+#define MAP_WIDTH 40                       // The engine's largest map is 40 by 40
+#define MAX_NODES (MAP_WIDTH * MAP_WIDTH)  // Maximum number of nodes in the map
+#define MAX_NEIGHBORS 8                    // Maximum number of neighbors a node can have
+#define SHORTIFY 100                       // Convert from float to short
+#define TILE_WIDTH 2.0f                    // Width of a tile
+
+static short SQRT_TWO = 142;  // Square root of two
+
+typedef std::chrono::steady_clock Clock;
+
+// Represents a position on the grid
+struct Position
+{
+	signed char x;
+	signed char y;
+
+	Position() : x(0), y(0) {}
+	Position(int X, int Y) : x(static_cast<signed char>(X)), y(static_cast<signed char>(Y)) {}
+};
+
+// The pathfinding data about any given position
+struct Node
+{
+	Position parent;     // Position that this node came from
+	Position position;   // Position of current node
+	short givenCost;     // Cost from start node
+	short estimateCost;  // Cost determined from method
+
+	short TotalCost() const { return givenCost + estimateCost; }
+};
+
+// The old preprocessed neighbors, one bool per direction
+struct Neighbor
+{
+	bool bottomLeft;
+	bool bottom;
+	bool bottomRight;
+	bool right;
+	bool left;
+	bool topLeft;
+	bool top;
+	bool topRight;
+};
+
+// The new preprocessed neighbors, bit i is NEIGHBOR_STEPS[i]
+typedef unsigned char NeighborMask;
+
+// A step to a neighbor, the same table as P2_Pathfinding.cpp
+struct NeighborStep
+{
+	signed char x;  // Column offset
+	signed char y;  // Row offset
+	bool diagonal;  // Costs SQRT_TWO instead of SHORTIFY
+};
+
+static const NeighborStep NEIGHBOR_STEPS[MAX_NEIGHBORS] =
+{
+	{  0, -1, false },  // Bottom
+	{ -1,  0, false },  // Left
+	{  1,  0, false },  // Right
+	{  0,  1, false },  // Top
+	{  1, -1, true  },  // Bottom right
+	{ -1, -1, true  },  // Bottom left
+	{ -1,  1, true  },  // Top left
+	{  1,  1, true  }   // Top right
+};
+
+/////////////////////////////
+// MAP
+/////////////////////////////
+
+static std::array<bool, MAX_NODES> walls;                // The terrain, row major
+static std::array<Neighbor, MAX_NODES> oldNeighbors;     // Old preprocessed neighbors
+static std::array<NeighborMask, MAX_NODES> newNeighbors; // New preprocessed neighbors
+static float goalWorldX;                                 // The request's goal, in world space like the engine's
+static float goalWorldY;
+
+static bool IsValid(int row, int col)
+{
+	return row >= 0 && col >= 0 && row < MAP_WIDTH && col < MAP_WIDTH;
+}
+
+static bool IsWall(int row, int col)
+{
+	return walls[row * MAP_WIDTH + col];
+}
+
+static int GetIndex(Position position)
+{
+	return position.y * MAP_WIDTH + position.x;
+}
+
+// What terrain->get_grid_position(request.goal) does on every call
+static Position GetGoal()
+{
+	return Position(static_cast<int>(goalWorldX / TILE_WIDTH), static_cast<int>(goalWorldY / TILE_WIDTH));
+}
+
+static short Octile(Position begin, Position end)
+{
+	// Variable because we do this calculation twice
+	int minimum = std::min(abs(begin.y - end.y), abs(begin.x - end.x));
+
+	// Min(xDiff, yDiff) * sqrt(2) + Max(xDiff, yDiff) - Min(xDiff, yDiff)
+	return static_cast<short>((minimum * SQRT_TWO) + (std::max(abs(begin.y - end.y), abs(begin.x - end.x)) - minimum) * SHORTIFY);
+}
+
+// Walls on about a quarter of the cells, then both neighbor tables for them
+static void MakeMap(std::mt19937 &random)
+{
+	for (int i = 0; i < MAX_NODES; ++i)
+		walls[i] = random() % 4 == 0;
+
+	for (int i = 0; i < MAX_NODES; ++i)
+	{
+		oldNeighbors[i] = Neighbor();
+		newNeighbors[i] = 0;
+
+		// Walls have no neighbors
+		if (walls[i])
+			continue;
+
+		for (int d = 0; d < MAX_NEIGHBORS; ++d)
+		{
+			int j = NEIGHBOR_STEPS[d].y;
+			int k = NEIGHBOR_STEPS[d].x;
+			int row = (i / MAP_WIDTH) + j;
+			int col = (i % MAP_WIDTH) + k;
+
+			// Off the map or into a wall
+			if (!IsValid(row, col) || IsWall(row, col))
+				continue;
+
+			// Diagonals can't cut a corner
+			if (NEIGHBOR_STEPS[d].diagonal && (IsWall((i / MAP_WIDTH) + j, i % MAP_WIDTH) || IsWall(i / MAP_WIDTH, (i % MAP_WIDTH) + k)))
+				continue;
+
+			newNeighbors[i] |= static_cast<NeighborMask>(1 << d);
+
+			// The old table has a named bool for each direction
+			bool *directions[MAX_NEIGHBORS] =
+			{
+				&oldNeighbors[i].bottom, &oldNeighbors[i].left, &oldNeighbors[i].right, &oldNeighbors[i].top,
+				&oldNeighbors[i].bottomRight, &oldNeighbors[i].bottomLeft, &oldNeighbors[i].topLeft, &oldNeighbors[i].topRight
+			};
+			*directions[d] = true;
+		}
+	}
+}
+
+/////////////////////////////
+// NEIGHBORS
+/////////////////////////////
+
+// The old CreateNode, looking the goal up for every neighbor
+static Node CreateOldNode(Position nodePosition, Node parent)
+{
+	Node returnNode;
+
+	returnNode.parent = parent.position;
+	returnNode.position = nodePosition;
+	returnNode.givenCost = static_cast<short>(parent.givenCost + SHORTIFY);
+	returnNode.estimateCost = Octile(nodePosition, GetGoal());
+
+	return returnNode;
+}
+
+// The old GetNeighbors, a table lookup per direction and a list node per neighbor
+static std::list<Node> GetOldNeighbors(Node current)
+{
+	std::list<Node> returnList;
+	int x = current.position.x;
+	int y = current.position.y;
+
+	// Adjacent neighbors
+	if (oldNeighbors[GetIndex(current.position)].bottom)
+		returnList.push_back(CreateOldNode(Position(x, y - 1), current));
+	if (oldNeighbors[GetIndex(current.position)].left)
+		returnList.push_back(CreateOldNode(Position(x - 1, y), current));
+	if (oldNeighbors[GetIndex(current.position)].right)
+		returnList.push_back(CreateOldNode(Position(x + 1, y), current));
+	if (oldNeighbors[GetIndex(current.position)].top)
+		returnList.push_back(CreateOldNode(Position(x, y + 1), current));
+
+	// Diagonal neighbors
+	const bool diagonals[4] =
+	{
+		oldNeighbors[GetIndex(current.position)].bottomRight, oldNeighbors[GetIndex(current.position)].bottomLeft,
+		oldNeighbors[GetIndex(current.position)].topLeft, oldNeighbors[GetIndex(current.position)].topRight
+	};
+	for (int d = 0; d < 4; ++d)
+	{
+		if (!diagonals[d])
+			continue;
+
+		Node diagonal = CreateOldNode(Position(x + NEIGHBOR_STEPS[d + 4].x, y + NEIGHBOR_STEPS[d + 4].y), current);
+		diagonal.givenCost = static_cast<short>(current.givenCost + SQRT_TWO);
+		returnList.push_back(diagonal);
+	}
+
+	return returnList;
+}
+
+// The new GetNeighbors, one mask read and a caller's array
+static int GetNewNeighbors(Node current, Position goal, Node *neighbors)
+{
+	NeighborMask mask = newNeighbors[GetIndex(current.position)];
+	int count = 0;
+
+	// Walk the set bits, in the same order as NEIGHBOR_STEPS
+	for (int d = 0; mask != 0; ++d, mask >>= 1)
+	{
+		if (!(mask & 1))
+			continue;
+
+		Node node;
+		node.parent = current.position;
+		node.position = Position(current.position.x + NEIGHBOR_STEPS[d].x, current.position.y + NEIGHBOR_STEPS[d].y);
+		node.givenCost = static_cast<short>(current.givenCost + (NEIGHBOR_STEPS[d].diagonal ? SQRT_TWO : SHORTIFY));
+		node.estimateCost = Octile(node.position, goal);
+		neighbors[count++] = node;
+	}
+
+	return count;
+}
+
+// Either storage, so the search around them is the same code
+struct OldStorage
+{
+	template <typename Visit>
+	static void Expand(Node current, Visit visit)
+	{
+		std::list<Node> neighbors = GetOldNeighbors(current);
+		for (auto &iter : neighbors)
+			visit(iter);
+	}
+};
+
+struct NewStorage
+{
+	template <typename Visit>
+	static void Expand(Node current, Visit visit)
+	{
+		Position goal = GetGoal();
+		Node neighbors[MAX_NEIGHBORS];
+		int neighborCount = GetNewNeighbors(current, goal, neighbors);
+		for (int n = 0; n < neighborCount; ++n)
+			visit(neighbors[n]);
+	}
+};
+
+/////////////////////////////
+// WORKLOADS
+/////////////////////////////
+
+// What a run did, compared between the storages to make sure they agree
+struct Totals
+{
+	long long expansions;  // nodes whose neighbors were generated
+	long long checksum;    // every neighbor's position and costs folded together
+	double seconds;        // time spent
+};
+
+// Expands every open cell once per pass, the neighbor generation on its own
+template <typename Storage>
+static Totals RunExpand(int passes)
+{
+	Totals totals = Totals();
+	Clock::time_point start = Clock::now();
+
+	for (int p = 0; p < passes; ++p)
+	{
+		for (int i = 0; i < MAX_NODES; ++i)
+		{
+			if (walls[i])
+				continue;
+
+			Node current;
+			current.position = current.parent = Position(i % MAP_WIDTH, i / MAP_WIDTH);
+			current.givenCost = static_cast<short>(p);
+			current.estimateCost = 0;
+
+			Storage::Expand(current, [&](const Node &neighbor)
+			{
+				totals.checksum += GetIndex(neighbor.position) + neighbor.givenCost * 7 + neighbor.estimateCost * 13;
+			});
+			++totals.expansions;
+		}
+	}
+
+	totals.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return totals;
+}
+
+// Orders the open list cheapest first
+struct Cheaper
+{
+	bool operator()(const Node &left, const Node &right) const { return left.TotalCost() > right.TotalCost(); }
+};
+
+// A* between random open cells, the neighbors inside a whole search
+template <typename Storage>
+static Totals RunSearch(int searches, unsigned seed)
+{
+	Totals totals = Totals();
+	std::mt19937 random(seed);
+	std::array<short, MAX_NODES> bestCost;
+
+	std::vector<int> open;
+	for (int i = 0; i < MAX_NODES; ++i)
+		if (!walls[i])
+			open.push_back(i);
+
+	Clock::time_point start = Clock::now();
+
+	for (int s = 0; s < searches; ++s)
+	{
+		int from = open[random() % open.size()];
+		int to = open[random() % open.size()];
+		goalWorldX = (to % MAP_WIDTH) * TILE_WIDTH + TILE_WIDTH / 2;
+		goalWorldY = (to / MAP_WIDTH) * TILE_WIDTH + TILE_WIDTH / 2;
+
+		bestCost.fill(SHRT_MAX);
+		std::priority_queue<Node, std::vector<Node>, Cheaper> list;
+
+		Node first;
+		first.position = first.parent = Position(from % MAP_WIDTH, from / MAP_WIDTH);
+		first.givenCost = 0;
+		first.estimateCost = Octile(first.position, GetGoal());
+		bestCost[from] = 0;
+		list.push(first);
+
+		while (!list.empty())
+		{
+			Node current = list.top();
+			list.pop();
+
+			// A cheaper copy was already expanded
+			if (current.givenCost > bestCost[GetIndex(current.position)])
+				continue;
+
+			if (GetIndex(current.position) == to)
+			{
+				totals.checksum += current.givenCost;
+				break;
+			}
+
+			Storage::Expand(current, [&](const Node &neighbor)
+			{
+				short &best = bestCost[GetIndex(neighbor.position)];
+				if (neighbor.givenCost < best)
+				{
+					best = neighbor.givenCost;
+					list.push(neighbor);
+				}
+			});
+			++totals.expansions;
+		}
+	}
+
+	totals.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return totals;
+}
+
+// One CSV row
+static void WriteRow(const char *workload, const char *storage, int maps, const Totals &totals)
+{
+	printf("%s,%s,%d,%lld,%.0f\n", workload, storage, maps, totals.expansions,
+	       totals.seconds > 0.0 ? totals.expansions / totals.seconds : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+	// --quick for a short run
+	int maps = (argc > 1 && strcmp(argv[1], "--quick") == 0) ? 5 : 50;
+	const int passes = 200;
+	const int searches = 200;
+
+	Totals oldExpand = Totals(), newExpand = Totals(), oldSearch = Totals(), newSearch = Totals();
+	std::mt19937 random(2024);
+
+	for (int m = 0; m < maps; ++m)
+	{
+		MakeMap(random);
+		goalWorldX = goalWorldY = MAP_WIDTH * TILE_WIDTH / 2;
+
+		// Both storages see the same maps and the same searches
+		Totals totals[4] =
+		{
+			RunExpand<OldStorage>(passes), RunExpand<NewStorage>(passes),
+			RunSearch<OldStorage>(searches, m), RunSearch<NewStorage>(searches, m)
+		};
+
+		Totals *sums[4] = { &oldExpand, &newExpand, &oldSearch, &newSearch };
+		for (int t = 0; t < 4; ++t)
+		{
+			sums[t]->expansions += totals[t].expansions;
+			sums[t]->checksum += totals[t].checksum;
+			sums[t]->seconds += totals[t].seconds;
+		}
+	}
+
+	printf("workload,storage,maps,expansions,expansions_per_second\n");
+	WriteRow("expand", "bool_struct_list", maps, oldExpand);
+	WriteRow("expand", "mask_inline_array", maps, newExpand);
+	WriteRow("search", "bool_struct_list", maps, oldSearch);
+	WriteRow("search", "mask_inline_array", maps, newSearch);
+
+	// Faster only counts if it's the same answer
+	if (oldExpand.checksum != newExpand.checksum || oldSearch.checksum != newSearch.checksum ||
+	    oldExpand.expansions != newExpand.expansions || oldSearch.expansions != newSearch.expansions)
+	{
+		fprintf(stderr, "the old and new neighbors disagree\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,463 @@
+/*!*************************************************************************************************
+\file    PageSource.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the heap, mmap, huge page and NUMA sources.
+***************************************************************************************************/
+
+#include "PageSource.h"  // PageSource, HeapPageSource, MmapPageSource, HugePageSource, NumaPageSource
+#include <algorithm>     // std::find
+#include <cstdint>       // std::uintptr_t
+#include <new>           // std::align_val_t, std::bad_alloc
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>    // mmap, munmap, madvise
+#include <unistd.h>      // sysconf
+#define OA_HAS_MMAP 1
+#else
+#define OA_HAS_MMAP 0
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h> // SYS_mbind, SYS_getcpu
+#endif
+
+// The system calls themselves, so there's no need for libnuma
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_getcpu)
+#include <cstdio>        // fopen, fgets, fclose
+#define OA_HAS_NUMA 1
+#else
+#define OA_HAS_NUMA 0
+#endif
+
+static const int NUMA_PREFERRED = 1;         // MPOL_PREFERRED from the kernel's mempolicy.h
+static const unsigned NUMA_MAX_NODES = 1024; // the most nodes a binding mask can name
+
+// Rounds an address or size up to a power of two
+static std::uintptr_t round_up(std::uintptr_t Value, size_t Alignment)
+{
+  return (Value + Alignment - 1) & ~(std::uintptr_t(Alignment) - 1);
+}
+
+/***************************************************************************************************
+  HeapPageSource
+***************************************************************************************************/
+
+void *HeapPageSource::AcquirePage(size_t Size, size_t Alignment)
+{
+  return operator new(Size, std::align_val_t(Alignment));
+}
+
+void HeapPageSource::ReleasePage(void *Page, size_t, size_t Alignment)
+{
+  // Has to match the aligned new in AcquirePage
+  operator delete(Page, std::align_val_t(Alignment));
+}
+
+// The source allocators use when their config doesn't name one, never destroyed
+HeapPageSource *HeapPageSource::GetDefault(void)
+{
+  // Never destroyed, so allocators with static storage can still give their pages back
+  static HeapPageSource *source = new HeapPageSource;
+
+  return source;
+}
+
+/***************************************************************************************************
+  MmapPageSource
+***************************************************************************************************/
+
+// Regions are reserved RegionBytes at a time (or one page, if that is bigger)
+MmapPageSource::MmapPageSource(size_t RegionBytes) : RegionBytes_(RegionBytes), DecommitBytes_(4096),
+                                                     Cursor_(nullptr), End_(nullptr), Published_(nullptr)
+{
+#if OA_HAS_MMAP
+  DecommitBytes_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Unmaps every region, pages still in use go with them (never throws)
+MmapPageSource::~MmapPageSource()
+{
+  for (size_t i = 0; i < Regions_.size(); ++i)
+    unmap_region(Regions_[i].Base, Regions_[i].Size);
+
+  for (size_t i = 0; i < Copies_.size(); ++i)
+    delete Copies_[i];
+}
+
+void *MmapPageSource::AcquirePage(size_t Size, size_t Alignment)
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  // Reuse a released page first, it keeps the pool in the regions it already has
+  for (size_t i = 0; i < Bins_.size(); ++i)
+  {
+    if (Bins_[i].Size == Size && Bins_[i].Alignment == Alignment && !Bins_[i].Pages.empty())
+    {
+      char* page = Bins_[i].Pages.back();
+      Bins_[i].Pages.pop_back();
+      return page;
+    }
+  }
+
+  // Carve it off the end of the newest region
+  char* page = reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(Cursor_), Alignment));
+  if (Cursor_ == nullptr || page + Size > End_)
+  {
+    // Whatever is left of the old region was never touched, so it costs no memory
+    size_t size = RegionBytes_ < Size + Alignment ? Size + Alignment : RegionBytes_;
+    char* region = map_region(size);
+    if (region == nullptr)
+      throw std::bad_alloc();
+
+    // Remember it before handing any of it out
+    try
+    {
+      Region entry = { region, size };
+      Regions_.push_back(entry);
+      publish_regions();
+    }
+    catch (std::bad_alloc&)
+    {
+      if (!Regions_.empty() && Regions_.back().Base == region)
+        Regions_.pop_back();
+      unmap_region(region, size);
+      throw;
+    }
+
+    Cursor_ = region;
+    End_ = region + size;
+    page = reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(Cursor_), Alignment));
+  }
+
+  Cursor_ = page + Size;
+  return page;
+}
+
+void MmapPageSource::ReleasePage(void *Page, size_t Size, size_t Alignment)
+{
+  char* page = static_cast<char*>(Page);
+
+  // A huge page region mapped on another thread can change it
+  size_t granularity = 0;
+  {
+    std::lock_guard<std::mutex> lock(Lock_);
+    granularity = DecommitBytes_;
+  }
+
+  // The addresses stay ours, only the memory behind them goes back, without holding up other threads
+  decommit(page, Size, granularity);
+
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  // Find the bin for this size, or start one
+  Bin* bin = nullptr;
+  for (size_t i = 0; i < Bins_.size() && bin == nullptr; ++i)
+    if (Bins_[i].Size == Size && Bins_[i].Alignment == Alignment)
+      bin = &Bins_[i];
+
+  try
+  {
+    if (bin == nullptr)
+    {
+      Bins_.push_back(Bin());
+      bin = &Bins_.back();
+      bin->Size = Size;
+      bin->Alignment = Alignment;
+    }
+
+    bin->Pages.push_back(page);
+  }
+  catch (std::bad_alloc&)
+  {
+    // Can't throw from here, the page just won't be reused
+  }
+}
+
+// Returns true if Address is inside one of the regions (never throws)
+// Takes no lock, so any thread can ask while others acquire and release pages
+bool MmapPageSource::Contains(const void *Address) const
+{
+  // Regions are only ever added, so a copy that's a little old can only miss a brand new one
+  const std::vector<Region>* regions = Published_.load(std::memory_order_acquire);
+  if (regions == nullptr)
+    return false;
+
+  const char* address = static_cast<const char*>(Address);
+  for (size_t i = 0; i < regions->size(); ++i)
+    if (address >= (*regions)[i].Base && address < (*regions)[i].Base + (*regions)[i].Size)
+      return true;
+
+  return false;
+}
+
+// returns how many regions have been mapped
+size_t MmapPageSource::GetRegionCount(void) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  return Regions_.size();
+}
+
+// returns the address space held by every region
+size_t MmapPageSource::GetReservedBytes(void) const
+{
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  size_t total = 0;
+  for (size_t i = 0; i < Regions_.size(); ++i)
+    total += Regions_[i].Size;
+
+  return total;
+}
+
+// Maps a region of at least Size bytes, sets Size to what was mapped (nullptr if it can't)
+char *MmapPageSource::map_region(size_t &Size)
+{
+  Size = round_up(Size, DecommitBytes_);
+
+#if OA_HAS_MMAP
+  // Only reserved, the system hands out memory as pages get touched
+  void* region = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  return region != MAP_FAILED ? static_cast<char*>(region) : nullptr;
+#else
+  return static_cast<char*>(operator new(Size, std::nothrow));
+#endif
+}
+
+// publishes a copy of Regions_ for Contains
+void MmapPageSource::publish_regions(void)
+{
+  // Room first, so a copy is never made that can't be freed later
+  Copies_.reserve(Copies_.size() + 1);
+  const std::vector<Region>* copy = new std::vector<Region>(Regions_);
+  Copies_.push_back(copy);
+
+  // Everything in the copy is written before a reader can find it
+  Published_.store(copy, std::memory_order_release);
+}
+
+// gives a region's memory back to the system
+void MmapPageSource::unmap_region(char *Region, size_t Size)
+{
+#if OA_HAS_MMAP
+  munmap(Region, Size);
+#else
+  (void)Size;
+  operator delete(Region);
+#endif
+}
+
+// returns a page's physical memory, keeping the addresses
+void MmapPageSource::decommit(char *Page, size_t Size, size_t Granularity)
+{
+#if OA_HAS_MMAP
+  // Only whole system pages inside the page can go, a neighbor might share the ones at the ends
+  char* begin = reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(Page), Granularity));
+  char* end = reinterpret_cast<char*>(reinterpret_cast<std::uintptr_t>(Page + Size) & ~(std::uintptr_t(Granularity) - 1));
+
+  // The next use reads zeros, which is fine since a new page gets set up from scratch
+  if (begin < end)
+    madvise(begin, end - begin, MADV_DONTNEED);
+#else
+  (void)Page;
+  (void)Size;
+  (void)Granularity;
+#endif
+}
+
+/***************************************************************************************************
+  HugePageSource
+***************************************************************************************************/
+
+// Regions are rounded up to a whole number of huge pages
+HugePageSource::HugePageSource(size_t RegionBytes) : MmapPageSource(round_up(RegionBytes, HUGE_PAGE_BYTES)),
+                                                     ReservedHugePages_(true)
+{
+}
+
+// Returns true if the regions so far came from the reserved huge page pool
+bool HugePageSource::UsingReservedHugePages(void) const
+{
+  // map_region can change it on whichever thread grows the pool
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  return ReservedHugePages_;
+}
+
+char *HugePageSource::map_region(size_t &Size)
+{
+  Size = round_up(Size, HUGE_PAGE_BYTES);
+
+#if OA_HAS_MMAP
+#ifdef MAP_HUGETLB
+  // Reserved huge pages, only there if the system set some aside
+  if (ReservedHugePages_)
+  {
+    void* region = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (region != MAP_FAILED)
+    {
+      // Huge pages can only be given back whole
+      DecommitBytes_ = HUGE_PAGE_BYTES;
+      return static_cast<char*>(region);
+    }
+
+    // Don't keep asking for something that isn't there
+    ReservedHugePages_ = false;
+  }
+#else
+  ReservedHugePages_ = false;
+#endif
+
+  // Map an extra huge page so the region can start on a huge page boundary
+  void* mapping = mmap(nullptr, Size + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED)
+    return nullptr;
+
+  // Trim off the unaligned ends
+  char* start = static_cast<char*>(mapping);
+  char* region = reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(start), HUGE_PAGE_BYTES));
+  if (region != start)
+    munmap(start, region - start);
+  if (region + Size != start + Size + HUGE_PAGE_BYTES)
+    munmap(region + Size, (start + Size + HUGE_PAGE_BYTES) - (region + Size));
+
+#ifdef MADV_HUGEPAGE
+  // Ask for transparent huge pages, the system is free to ignore it
+  madvise(region, Size, MADV_HUGEPAGE);
+#endif
+
+  return region;
+#else
+  ReservedHugePages_ = false;
+  return MmapPageSource::map_region(Size);
+#endif
+}
+
+/***************************************************************************************************
+  NumaPageSource
+***************************************************************************************************/
+
+// Regions come from Node's memory when the system can place them
+NumaPageSource::NumaPageSource(unsigned Node, size_t RegionBytes) : MmapPageSource(RegionBytes), Node_(Node),
+                                                                    Bound_(false)
+{
+  // Only an online node can be bound to, and with one node there's nothing to choose
+  const std::vector<unsigned>& nodes = GetNodes();
+  Bound_ = nodes.size() > 1 && std::find(nodes.begin(), nodes.end(), Node) != nodes.end();
+}
+
+// returns the node the regions are bound to
+unsigned NumaPageSource::GetNode(void) const
+{
+  return Node_;
+}
+
+// returns true if every region so far was bound to the node
+bool NumaPageSource::IsBound(void) const
+{
+  // map_region can change it on whichever thread grows the pool
+  std::lock_guard<std::mutex> lock(Lock_);
+
+  return Bound_;
+}
+
+// returns every online node, in order (just 0 without NUMA)
+const std::vector<unsigned> &NumaPageSource::GetNodes(void)
+{
+  // The nodes don't change while we run, so only read them once
+  static const std::vector<unsigned> nodes = []()
+  {
+    std::vector<unsigned> online;
+
+#if OA_HAS_NUMA
+    // Something like "0-1" or "0,2-3", node IDs can have gaps
+    FILE* file = fopen("/sys/devices/system/node/online", "r");
+    if (file != nullptr)
+    {
+      char line[256];
+      if (fgets(line, sizeof(line), file) != nullptr)
+      {
+        for (const char* c = line; *c >= '0' && *c <= '9'; )
+        {
+          unsigned first = 0;
+          while (*c >= '0' && *c <= '9')
+            first = first * 10 + (*c++ - '0');
+
+          unsigned last = first;
+          if (*c == '-')
+          {
+            last = 0;
+            for (++c; *c >= '0' && *c <= '9'; ++c)
+              last = last * 10 + (*c - '0');
+          }
+
+          // A binding mask can't name anything past the last node it holds
+          for (unsigned node = first; node <= last && node < NUMA_MAX_NODES; ++node)
+            online.push_back(node);
+
+          if (*c == ',')
+            ++c;
+        }
+      }
+
+      fclose(file);
+    }
+#endif
+
+    // No NUMA, or nothing could be read, is one node
+    if (online.empty())
+      online.push_back(0);
+
+    return online;
+  }();
+
+  return nodes;
+}
+
+// returns how many NUMA nodes are online (1 without NUMA)
+unsigned NumaPageSource::GetNodeCount(void)
+{
+  return static_cast<unsigned>(GetNodes().size());
+}
+
+// returns the node the calling thread is running on (0 without NUMA)
+unsigned NumaPageSource::GetCurrentNode(void)
+{
+#if OA_HAS_NUMA
+  // One node means there's nothing to ask
+  if (GetNodeCount() == 1)
+    return 0;
+
+  // The thread can be moved right after, so this is only where it was a moment ago
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+    return node;
+#endif
+
+  return 0;
+}
+
+char *NumaPageSource::map_region(size_t &Size)
+{
+  char* region = MmapPageSource::map_region(Size);
+
+#if OA_HAS_NUMA
+  // Nothing has touched the region yet, so every page of it will be placed by the binding
+  if (region != nullptr && Bound_)
+  {
+    const unsigned bits = sizeof(unsigned long) * 8;
+    unsigned long mask[NUMA_MAX_NODES / (sizeof(unsigned long) * 8)] = {};
+    mask[Node_ / bits] |= 1ul << (Node_ % bits);
+
+    // The kernel reads one bit less than the count it's given
+    if (syscall(SYS_mbind, region, Size, NUMA_PREFERRED, mask, static_cast<unsigned long>(Node_) + 2, 0) != 0)
+      Bound_ = false;
+  }
+#endif
+
+  return region;
+}
@@ -0,0 +1,176 @@
+/*!*************************************************************************************************
+\file    PageSource.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the interface an ObjectAllocator gets its pages from, along with a heap,
+         an mmap arena, a huge page arena and a NUMA node local arena back end.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef PAGESOURCEH
+#define PAGESOURCEH
+//--------------------------------------------------------------------------------------------------
+
+#include <atomic>   // std::atomic
+#include <cstddef>  // size_t
+#include <mutex>    // std::mutex
+#include <vector>   // std::vector
+
+// Where an ObjectAllocator's pages come from and go back to
+// One source can be shared by many allocators, and has to outlive all of them
+class PageSource
+{
+  public:
+
+    virtual ~PageSource() {}
+
+    // Gets Size bytes at a power of two Alignment
+    // Throws std::bad_alloc if the memory can't be allocated
+    virtual void *AcquirePage(size_t Size, size_t Alignment) = 0;
+
+    // Gives back a page from AcquirePage, Size and Alignment have to match the request (never throws)
+    virtual void ReleasePage(void *Page, size_t Size, size_t Alignment) = 0;
+
+};
+
+// Every page is its own operator new, the same as an allocator without a source
+class HeapPageSource : public PageSource
+{
+  public:
+
+    void *AcquirePage(size_t Size, size_t Alignment) override;
+    void ReleasePage(void *Page, size_t Size, size_t Alignment) override;
+
+    // The source allocators use when their config doesn't name one, never destroyed
+    static HeapPageSource *GetDefault(void);
+
+};
+
+// Carves pages out of large mmap'd regions, so a big pool sits in a few contiguous mappings
+// Released pages are recycled, their memory goes back to the system with madvise(MADV_DONTNEED)
+// Falls back to the heap where mmap isn't available
+class MmapPageSource : public PageSource
+{
+  public:
+
+    static const size_t DEFAULT_REGION_BYTES = 64 * 1024 * 1024;
+
+    // Regions are reserved RegionBytes at a time (or one page, if that is bigger)
+    explicit MmapPageSource(size_t RegionBytes = DEFAULT_REGION_BYTES);
+
+    // Unmaps every region, pages still in use go with them (never throws)
+    ~MmapPageSource();
+
+    void *AcquirePage(size_t Size, size_t Alignment) override;
+    void ReleasePage(void *Page, size_t Size, size_t Alignment) override;
+
+    // Returns true if Address is inside one of the regions (never throws)
+    // Takes no lock, so any thread can ask while others acquire and release pages
+    bool Contains(const void *Address) const;
+
+    // Testing/Debugging/Statistic methods
+    size_t GetRegionCount(void) const;     // returns how many regions have been mapped
+    size_t GetReservedBytes(void) const;   // returns the address space held by every region
+
+  protected:
+
+    // Maps a region of at least Size bytes, sets Size to what was mapped (nullptr if it can't)
+    // Always called with Lock_ held, so anything it changes has to be read under Lock_ as well
+    virtual char *map_region(size_t &Size);
+
+    mutable std::mutex Lock_;  // allocators on different threads can share a source
+    size_t RegionBytes_;       // how much address space each region reserves
+    size_t DecommitBytes_;     // the smallest range madvise can give back (guarded by Lock_)
+
+  private:
+
+    // Released pages of one size and alignment, waiting to be handed out again
+    struct Bin
+    {
+      size_t Size;
+      size_t Alignment;
+      std::vector<char*> Pages;
+    };
+
+    // One mapping, kept so it can be unmapped
+    struct Region
+    {
+      char *Base;
+      size_t Size;
+    };
+
+    std::vector<Region> Regions_;  // every region mapped so far
+    std::vector<Bin> Bins_;        // released pages by size and alignment
+    char *Cursor_;                 // next unused byte of the newest region
+    char *End_;                    // end of the newest region
+
+    // Contains reads the latest copy of Regions_, a copy is never changed once published
+    // Older copies are kept until the source goes, a reader could still be walking one
+    std::atomic<const std::vector<Region>*> Published_;  // the latest copy of Regions_
+    std::vector<const std::vector<Region>*> Copies_;     // every copy published so far
+
+    void publish_regions(void);  // publishes a copy of Regions_ for Contains
+
+    static void decommit(char *Page, size_t Size, size_t Granularity);  // returns a page's physical memory, keeping the addresses
+    static void unmap_region(char *Region, size_t Size);  // gives a region's memory back to the system
+
+    // Make private to prevent copy construction and assignment
+    MmapPageSource(const MmapPageSource &mps);
+    MmapPageSource &operator=(const MmapPageSource &mps);
+
+};
+
+// An MmapPageSource backed by huge pages, which cuts TLB misses on big pools
+// Uses MAP_HUGETLB when the system has huge pages reserved, otherwise asks for transparent huge pages
+class HugePageSource : public MmapPageSource
+{
+  public:
+
+    static const size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+    // Regions are rounded up to a whole number of huge pages
+    explicit HugePageSource(size_t RegionBytes = DEFAULT_REGION_BYTES);
+
+    // Returns true if the regions so far came from the reserved huge page pool
+    bool UsingReservedHugePages(void) const;
+
+  protected:
+
+    char *map_region(size_t &Size) override;
+
+  private:
+
+    bool ReservedHugePages_;  // MAP_HUGETLB worked, so keep using it (guarded by Lock_)
+
+};
+
+// An MmapPageSource whose regions prefer the memory of one NUMA node
+// Each region is bound before anything touches it, so it doesn't matter which thread grows the pool
+// The binding is only a preference, a full node spills onto the others instead of failing
+// Without NUMA (one node, or not Linux) it behaves the same as MmapPageSource
+class NumaPageSource : public MmapPageSource
+{
+  public:
+
+    // Regions come from Node's memory when the system can place them
+    explicit NumaPageSource(unsigned Node, size_t RegionBytes = DEFAULT_REGION_BYTES);
+
+    // Testing/Debugging/Statistic methods
+    unsigned GetNode(void) const;          // returns the node the regions are bound to
+    bool IsBound(void) const;              // returns true if every region so far was bound to the node
+    static const std::vector<unsigned> &GetNodes(void);  // returns every online node, in order (just 0 without NUMA)
+    static unsigned GetNodeCount(void);    // returns how many NUMA nodes are online (1 without NUMA)
+    static unsigned GetCurrentNode(void);  // returns the node the calling thread is running on (0 without NUMA)
+
+  protected:
+
+    char *map_region(size_t &Size) override;
+
+  private:
+
+    unsigned Node_;  // where the regions should live
+    bool Bound_;     // every region so far was bound (guarded by Lock_)
+
+};
+
+#endif
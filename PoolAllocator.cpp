@@ -0,0 +1,165 @@
+/*!*************************************************************************************************
+\file    PoolAllocator.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the NodePoolResource.
+***************************************************************************************************/
+
+#include "PoolAllocator.h"  // NodePoolResource
+
+// The config is used for every pool (debug, padding, threading), except for ObjectsPerPage_
+// Pools are created on first use, so this only throws if the pool table can't be made
+NodePoolResource::NodePoolResource(const OAConfig &config, size_t PageBytes, std::pmr::memory_resource *upstream)
+                                   : Configuration_(config), PageBytes_(PageBytes), Upstream_(upstream)
+{
+  for (unsigned i = 0; i < POOL_COUNT; ++i)
+    Pools_[i].store(nullptr, std::memory_order_relaxed);
+}
+
+// Destroys every pool (never throws)
+NodePoolResource::~NodePoolResource()
+{
+  for (unsigned i = 0; i < POOL_COUNT; ++i)
+    delete Pools_[i].load(std::memory_order_relaxed);
+}
+
+// The resource a default constructed PoolAllocator uses, thread safe and never destroyed
+NodePoolResource *NodePoolResource::GetDefault(void)
+{
+  // Never destroyed, so containers with static storage can still free into it
+  static NodePoolResource *resource = []()
+  {
+    // Every thread shares it, so the pools have to be thread safe
+    OAConfig config(false, DEFAULT_OBJECTS_PER_PAGE, 0);
+    config.ThreadCacheSize_ = 64;
+
+    return new NodePoolResource(config);
+  }();
+
+  return resource;
+}
+
+/***************************************************************************************************
+  Testing/Debugging/Statistic methods
+***************************************************************************************************/
+
+// returns the statistics for the pool of a node size
+OAStats NodePoolResource::GetStats(size_t Size) const
+{
+  ObjectAllocator* pool = find_pool(Size, 0);
+
+  return pool != nullptr ? pool->GetStats() : OAStats();
+}
+
+// returns how many pools have been created
+unsigned NodePoolResource::GetPoolCount(void) const
+{
+  unsigned count = 0;
+
+  for (unsigned i = 0; i < POOL_COUNT; ++i)
+    if (Pools_[i].load(std::memory_order_acquire) != nullptr)
+      ++count;
+
+  return count;
+}
+
+/***************************************************************************************************
+  Private methods
+***************************************************************************************************/
+
+// finds or makes the pool for a request (nullptr if none)
+ObjectAllocator *NodePoolResource::get_pool(size_t Size, size_t Alignment)
+{
+  ObjectAllocator* pool = find_pool(Size, Alignment);
+
+  // Already made, or no pool can take it
+  if (pool != nullptr || Size == 0 || Size > MAX_NODE_SIZE ||
+      get_pool_alignment((Size + 7) & ~size_t(7)) < Alignment)
+    return pool;
+
+  std::lock_guard<std::mutex> lock(PoolLock_);
+
+  // Someone else might have made it while we waited
+  size_t index = (Size - 1) / 8;
+  pool = Pools_[index].load(std::memory_order_acquire);
+  if (pool != nullptr)
+    return pool;
+
+  // The same config, just sized for this node
+  size_t size = (index + 1) * 8;
+  OAConfig poolConfig = Configuration_;
+  poolConfig.ObjectsPerPage_ = static_cast<unsigned>(PageBytes_ / size);
+  if (poolConfig.ObjectsPerPage_ < DEFAULT_OBJECTS_PER_PAGE)
+    poolConfig.ObjectsPerPage_ = DEFAULT_OBJECTS_PER_PAGE;
+  poolConfig.Alignment_ = static_cast<unsigned>(get_pool_alignment(size));
+
+  try
+  {
+    pool = new ObjectAllocator(size, poolConfig);
+  }
+  catch (std::bad_alloc&)
+  {
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+
+  Pools_[index].store(pool, std::memory_order_release);
+  return pool;
+}
+
+// finds the pool for a request without making it
+ObjectAllocator *NodePoolResource::find_pool(size_t Size, size_t Alignment) const
+{
+  if (Size == 0 || Size > MAX_NODE_SIZE)
+    return nullptr;
+
+  // Nodes are rounded up to a multiple of 8, the pool also has to be aligned enough
+  size_t index = (Size - 1) / 8;
+  if (get_pool_alignment((index + 1) * 8) < Alignment)
+    return nullptr;
+
+  return Pools_[index].load(std::memory_order_acquire);
+}
+
+// alignment every node of a pool gets
+size_t NodePoolResource::get_pool_alignment(size_t Size)
+{
+  // The largest power of two the size is a multiple of, up to what operator new would give
+  size_t alignment = Size & (~Size + 1);
+
+  return alignment < alignof(std::max_align_t) ? alignment : alignof(std::max_align_t);
+}
+
+void *NodePoolResource::do_allocate(size_t bytes, size_t alignment)
+{
+  // pmr containers expect std::bad_alloc
+  try
+  {
+    ObjectAllocator* pool = get_pool(bytes, alignment);
+    if (pool != nullptr)
+      return pool->Allocate();
+  }
+  catch (OAException&)
+  {
+    throw std::bad_alloc();
+  }
+
+  // Too big or aligned more than any pool can do
+  return Upstream_->allocate(bytes, alignment);
+}
+
+void NodePoolResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+  // A pool always exists for memory that came from one
+  ObjectAllocator* pool = find_pool(bytes, alignment);
+
+  if (pool != nullptr)
+    pool->Free(p);
+  else
+    Upstream_->deallocate(p, bytes, alignment);
+}
+
+bool NodePoolResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+  // Every size has its own pool, so no other resource can free our memory
+  return this == &other;
+}
@@ -0,0 +1,128 @@
+/*!*************************************************************************************************
+\file    PoolAllocator.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds a node pool memory_resource and an STL allocator that let standard
+         containers allocate their nodes out of ObjectAllocator pools.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef POOLALLOCATORH
+#define POOLALLOCATORH
+//--------------------------------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"  // ObjectAllocator, OAConfig, OAStats
+#include <atomic>             // std::atomic
+#include <cstddef>            // std::max_align_t
+#include <memory_resource>    // std::pmr::memory_resource
+#include <mutex>              // std::mutex
+#include <new>                // std::bad_array_new_length
+
+// Gives every node size its own pool, the first request for a size creates its pool
+class NodePoolResource : public std::pmr::memory_resource
+{
+  public:
+
+    static const size_t MAX_NODE_SIZE = 512;             // anything bigger goes upstream
+    static const unsigned POOL_COUNT = MAX_NODE_SIZE / 8; // one pool for every multiple of 8 bytes
+    static const size_t DEFAULT_PAGE_BYTES = 4096;
+
+    // The config is used for every pool (debug, padding, threading), except for ObjectsPerPage_
+    // Pools are created on first use, so this only throws if the pool table can't be made
+    NodePoolResource(const OAConfig &config = OAConfig(false, DEFAULT_OBJECTS_PER_PAGE, 0),
+                     size_t PageBytes = DEFAULT_PAGE_BYTES,
+                     std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+
+    // Destroys every pool (never throws)
+    ~NodePoolResource();
+
+    // The resource a default constructed PoolAllocator uses, thread safe and never destroyed
+    static NodePoolResource *GetDefault(void);
+
+    // Testing/Debugging/Statistic methods
+    OAStats GetStats(size_t Size) const;  // returns the statistics for the pool of a node size
+    unsigned GetPoolCount(void) const;    // returns how many pools have been created
+
+  private:
+
+    std::atomic<ObjectAllocator*> Pools_[POOL_COUNT];  // pool for each multiple of 8 bytes (nullptr=not made yet)
+    std::mutex PoolLock_;                              // only taken while a pool is being made
+    OAConfig Configuration_;                           // what every pool is made with
+    size_t PageBytes_;                                 // about how much each page of a pool holds
+    std::pmr::memory_resource *Upstream_;              // where large and over-aligned requests go
+
+    ObjectAllocator *get_pool(size_t Size, size_t Alignment);  // finds or makes the pool for a request (nullptr if none)
+    ObjectAllocator *find_pool(size_t Size, size_t Alignment) const; // finds the pool for a request without making it
+    static size_t get_pool_alignment(size_t Size);              // alignment every node of a pool gets
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    // Make private to prevent copy construction and assignment
+    NodePoolResource(const NodePoolResource &npr);
+    NodePoolResource &operator=(const NodePoolResource &npr);
+
+};
+
+// Drop in std::allocator replacement, e.g. std::list<Node, PoolAllocator<Node> >
+// Containers rebind it to their node type, so each node size ends up in its own pool
+template <typename T>
+class PoolAllocator
+{
+  public:
+
+    typedef T value_type;
+
+    // Uses the shared default resource
+    PoolAllocator() noexcept : resource_(NodePoolResource::GetDefault()) {}
+
+    // Uses any resource, which has to outlive every container using it
+    PoolAllocator(std::pmr::memory_resource *resource) noexcept : resource_(resource) {}
+
+    // Rebinding keeps the same resource
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &other) noexcept : resource_(other.resource()) {}
+
+    // Gets memory for Count objects
+    // Throws std::bad_alloc if the memory can't be allocated
+    T *allocate(size_t Count)
+    {
+      if (Count > size_t(-1) / sizeof(T))
+        throw std::bad_array_new_length();
+
+      return static_cast<T*>(resource_->allocate(Count * sizeof(T), alignof(T)));
+    }
+
+    // Gives back memory from allocate, Count has to match the request
+    void deallocate(T *Object, size_t Count)
+    {
+      resource_->deallocate(Object, Count * sizeof(T), alignof(T));
+    }
+
+    // returns the resource the memory comes from
+    std::pmr::memory_resource *resource(void) const noexcept
+    {
+      return resource_;
+    }
+
+  private:
+
+    std::pmr::memory_resource *resource_;  // where the memory comes from
+
+};
+
+// Memory from one allocator can be freed by the other if they share a resource
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> &left, const PoolAllocator<U> &right) noexcept
+{
+  return left.resource() == right.resource() || left.resource()->is_equal(*right.resource());
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> &left, const PoolAllocator<U> &right) noexcept
+{
+  return !(left == right);
+}
+
+#endif
@@ -0,0 +1,301 @@
+/*!*************************************************************************************************
+\file    SmallObjectAllocator.cpp
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the implementation for the SmallObjectAllocator.
+***************************************************************************************************/
+
+#include "SmallObjectAllocator.h"  // SmallObjectAllocator, SmallObjectResource
+#include <algorithm>               // std::min
+#include <mutex>                   // std::unique_lock
+#include <new>                     // std::align_val_t, std::bad_alloc
+
+// The object size of every pool, powers of two with a step in between
+static const size_t SIZE_CLASSES[SmallObjectAllocator::CLASS_COUNT] =
+{
+  8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+// Creates one pool per size class, each page holds about PageBytes worth of objects
+// Throws an exception if the construction fails. (Memory allocation problem)
+SmallObjectAllocator::SmallObjectAllocator(const OAConfig &config, size_t PageBytes) : LargeAllocations_(0),
+                                                                                        SystemHeap_(config.UseCPPMemManager_)
+{
+  // Nothing to clean up if a pool fails part way through, and every page is recorded on its way to a pool
+  for (unsigned i = 0; i < CLASS_COUNT; ++i)
+  {
+    Pools_[i] = nullptr;
+    PageSources_[i].Owner_ = this;
+    PageSources_[i].Source_ = config.PageSource_ != nullptr ? config.PageSource_ : HeapPageSource::GetDefault();
+    PageSources_[i].SizeClass_ = i;
+  }
+
+  try
+  {
+    for (unsigned i = 0; i < CLASS_COUNT; ++i)
+    {
+      // The same config, just sized for this class
+      OAConfig poolConfig = config;
+      poolConfig.ObjectsPerPage_ = static_cast<unsigned>(PageBytes / SIZE_CLASSES[i]);
+      if (poolConfig.ObjectsPerPage_ < DEFAULT_OBJECTS_PER_PAGE)
+        poolConfig.ObjectsPerPage_ = DEFAULT_OBJECTS_PER_PAGE;
+      poolConfig.Alignment_ = static_cast<unsigned>(get_class_alignment(i));
+      poolConfig.PageSource_ = &PageSources_[i];
+
+      Pools_[i] = new ObjectAllocator(SIZE_CLASSES[i], poolConfig);
+    }
+  }
+  catch (std::bad_alloc&)
+  {
+    for (unsigned i = 0; i < CLASS_COUNT; ++i)
+      delete Pools_[i];
+
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+  catch (OAException&)
+  {
+    for (unsigned i = 0; i < CLASS_COUNT; ++i)
+      delete Pools_[i];
+
+    throw;
+  }
+
+  // Every multiple of 8 bytes maps straight to the smallest class that fits it
+  unsigned sizeClass = 0;
+  for (size_t i = 0; i <= MAX_SMALL_SIZE / 8; ++i)
+  {
+    while (SIZE_CLASSES[sizeClass] < i * 8)
+      ++sizeClass;
+
+    ClassIndex_[i] = static_cast<unsigned char>(sizeClass);
+  }
+}
+
+// Destroys every pool (never throws)
+SmallObjectAllocator::~SmallObjectAllocator()
+{
+  for (unsigned i = 0; i < CLASS_COUNT; ++i)
+    delete Pools_[i];
+}
+
+// Gets memory for Size bytes at the given alignment (simulates malloc)
+// Throws an exception if the memory can't be allocated. (Memory allocation problem)
+void *SmallObjectAllocator::Allocate(size_t Size, size_t Alignment)
+{
+  int sizeClass = get_size_class(Size, Alignment);
+
+  // Small enough for one of the pools
+  if (sizeClass >= 0)
+    return Pools_[sizeClass]->Allocate();
+
+  // Only a count, so it doesn't have to order anything
+  LargeAllocations_.fetch_add(1, std::memory_order_relaxed);
+
+  try
+  {
+    // Too big, or aligned more than any pool can do
+    if (Alignment > alignof(std::max_align_t))
+      return operator new(Size, std::align_val_t(Alignment));
+
+    return operator new(Size);
+  }
+  catch (std::bad_alloc&)
+  {
+    throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+  }
+}
+
+// Gives back memory from Allocate, Size and Alignment have to match the request
+// Throws an exception if the object can't be freed. (Invalid object)
+void SmallObjectAllocator::Free(void *Object, size_t Size, size_t Alignment)
+{
+  if (Object == nullptr)
+    return;
+
+  int sizeClass = get_size_class(Size, Alignment);
+
+  // It came from one of the pools
+  if (sizeClass >= 0)
+  {
+    Pools_[sizeClass]->Free(Object);
+    return;
+  }
+
+  // It came from the system
+  if (Alignment > alignof(std::max_align_t))
+    operator delete(Object, std::align_val_t(Alignment));
+  else
+    operator delete(Object);
+}
+
+// Gives back memory from Allocate with an Alignment of 0 when the size isn't known (simulates free)
+// One lookup in a map of every pool's pages finds the class, prefer the sized Free when the size is known
+// Throws an exception if the object can't be freed. (Invalid object)
+void SmallObjectAllocator::Free(void *Object)
+{
+  if (Object == nullptr)
+    return;
+
+  // The pools have no pages on the system heap, so only asking them works (debug tracks their objects)
+  if (SystemHeap_)
+  {
+    for (unsigned i = 0; i < CLASS_COUNT; ++i)
+    {
+      if (Pools_[i]->Owns(Object))
+      {
+        Pools_[i]->Free(Object);
+        return;
+      }
+    }
+  }
+  else
+  {
+    int sizeClass = find_page_class(Object);
+
+    // It's on one of the pools' pages
+    if (sizeClass >= 0)
+    {
+      Pools_[sizeClass]->Free(Object);
+      return;
+    }
+  }
+
+  // Nobody has it, so it came from the system
+  operator delete(Object);
+}
+
+/***************************************************************************************************
+  Testing/Debugging/Statistic methods
+***************************************************************************************************/
+
+// returns the object size of a size class
+size_t SmallObjectAllocator::GetClassSize(unsigned SizeClass)
+{
+  return SizeClass < CLASS_COUNT ? SIZE_CLASSES[SizeClass] : 0;
+}
+
+// returns the statistics for a size class
+OAStats SmallObjectAllocator::GetStats(unsigned SizeClass) const
+{
+  return SizeClass < CLASS_COUNT ? Pools_[SizeClass]->GetStats() : OAStats();
+}
+
+// returns how many requests went to the system
+size_t SmallObjectAllocator::GetLargeAllocations(void) const
+{
+  return LargeAllocations_.load(std::memory_order_relaxed);
+}
+
+/***************************************************************************************************
+  Private methods
+***************************************************************************************************/
+
+// finds the pool for a request (-1 if none)
+int SmallObjectAllocator::get_size_class(size_t Size, size_t Alignment) const
+{
+  // Too big for any pool
+  if (Size > MAX_SMALL_SIZE)
+    return -1;
+
+  // Straight from the table, rounding the size up to a multiple of 8
+  unsigned sizeClass = ClassIndex_[(Size + 7) / 8];
+
+  // Like malloc, an object can't need more alignment than the largest power of two its size is a multiple of,
+  // and never more than malloc itself gives, the same cap the classes have
+  if (Alignment == 0)
+    Alignment = std::min<size_t>(Size != 0 ? (Size & (~Size + 1)) : 1, alignof(std::max_align_t));
+
+  // Step up until the class is aligned enough, this is rare
+  while (sizeClass < CLASS_COUNT && get_class_alignment(sizeClass) < Alignment)
+    ++sizeClass;
+
+  return sizeClass < CLASS_COUNT ? static_cast<int>(sizeClass) : -1;
+}
+
+// finds the pool whose page holds an object (-1 if none)
+int SmallObjectAllocator::find_page_class(const void *Object) const
+{
+  const char* address = static_cast<const char*>(Object);
+  std::shared_lock<std::shared_mutex> lock(PagesLock_);
+
+  // The last page that starts at or before the object
+  std::map<const char*, PageRange>::const_iterator page = Pages_.upper_bound(address);
+  if (page == Pages_.begin())
+    return -1;
+  --page;
+
+  return address < page->second.End ? static_cast<int>(page->second.SizeClass) : -1;
+}
+
+// alignment every object in a class gets
+size_t SmallObjectAllocator::get_class_alignment(unsigned SizeClass)
+{
+  // The largest power of two the size is a multiple of, up to what malloc would give
+  size_t size = SIZE_CLASSES[SizeClass];
+  size_t alignment = size & (~size + 1);
+
+  return alignment < alignof(std::max_align_t) ? alignment : alignof(std::max_align_t);
+}
+
+/***************************************************************************************************
+  ClassPageSource
+***************************************************************************************************/
+
+void *SmallObjectAllocator::ClassPageSource::AcquirePage(size_t Size, size_t Alignment)
+{
+  char* page = static_cast<char*>(Source_->AcquirePage(Size, Alignment));
+
+  // Recorded before the pool can hand out anything on it
+  try
+  {
+    std::unique_lock<std::shared_mutex> lock(Owner_->PagesLock_);
+    Owner_->Pages_[page] = PageRange{page + Size, SizeClass_};
+  }
+  catch (std::bad_alloc&)
+  {
+    Source_->ReleasePage(page, Size, Alignment);
+    throw;
+  }
+
+  return page;
+}
+
+void SmallObjectAllocator::ClassPageSource::ReleasePage(void *Page, size_t Size, size_t Alignment)
+{
+  // Forgotten first, the source may hand the same memory to another pool
+  {
+    std::unique_lock<std::shared_mutex> lock(Owner_->PagesLock_);
+    Owner_->Pages_.erase(static_cast<const char*>(Page));
+  }
+
+  Source_->ReleasePage(Page, Size, Alignment);
+}
+
+/***************************************************************************************************
+  SmallObjectResource
+***************************************************************************************************/
+
+void *SmallObjectResource::do_allocate(size_t bytes, size_t alignment)
+{
+  // pmr containers expect std::bad_alloc
+  try
+  {
+    return allocator_.Allocate(bytes, alignment);
+  }
+  catch (OAException&)
+  {
+    throw std::bad_alloc();
+  }
+}
+
+void SmallObjectResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+  allocator_.Free(p, bytes, alignment);
+}
+
+bool SmallObjectResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+  // Only interchangeable if they share the same allocator
+  const SmallObjectResource *resource = dynamic_cast<const SmallObjectResource*>(&other);
+  return resource != nullptr && &resource->allocator_ == &allocator_;
+}
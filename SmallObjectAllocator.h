@@ -0,0 +1,118 @@
+/*!*************************************************************************************************
+\file    SmallObjectAllocator.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds the public interface for the SmallObjectAllocator, a general purpose
+         allocator built out of one ObjectAllocator per size class.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef SMALLOBJECTALLOCATORH
+#define SMALLOBJECTALLOCATORH
+//--------------------------------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"  // ObjectAllocator, OAConfig, OAStats
+#include "PageSource.h"       // PageSource
+#include <atomic>             // std::atomic
+#include <cstddef>            // std::max_align_t
+#include <map>                // std::map
+#include <memory_resource>    // std::pmr::memory_resource
+#include <shared_mutex>       // std::shared_mutex
+
+// Routes malloc style requests to the pool for their size class, large requests go to the system
+class SmallObjectAllocator
+{
+  public:
+
+    static const size_t MAX_SMALL_SIZE = 1024;  // anything bigger goes to operator new
+    static const unsigned CLASS_COUNT = 14;     // 8 to 1024 bytes in steps of about 1.5x
+    static const size_t DEFAULT_PAGE_BYTES = 16384;
+
+    // Creates one pool per size class, each page holds about PageBytes worth of objects
+    // The config is used for every pool (debug, padding, threading), except for ObjectsPerPage_
+    // Throws an exception if the construction fails. (Memory allocation problem)
+    SmallObjectAllocator(const OAConfig &config = OAConfig(false, DEFAULT_OBJECTS_PER_PAGE, 0),
+                         size_t PageBytes = DEFAULT_PAGE_BYTES);
+
+    // Destroys every pool (never throws)
+    ~SmallObjectAllocator();
+
+    // Gets memory for Size bytes at the given alignment (simulates malloc)
+    // An Alignment of 0 gives what malloc would, enough for any object of that size
+    // Throws an exception if the memory can't be allocated. (Memory allocation problem)
+    void *Allocate(size_t Size, size_t Alignment = 0);
+
+    // Gives back memory from Allocate, Size and Alignment have to match the request
+    // Throws an exception if the object can't be freed. (Invalid object)
+    void Free(void *Object, size_t Size, size_t Alignment = 0);
+
+    // Gives back memory from Allocate with an Alignment of 0 when the size isn't known (simulates free)
+    // One lookup in a map of every pool's pages finds the class, prefer the sized Free when the size is known
+    // Throws an exception if the object can't be freed. (Invalid object)
+    void Free(void *Object);
+
+    // Testing/Debugging/Statistic methods
+    static size_t GetClassSize(unsigned SizeClass);        // returns the object size of a size class
+    OAStats GetStats(unsigned SizeClass) const;           // returns the statistics for a size class
+    size_t GetLargeAllocations(void) const;               // returns how many requests went to the system
+
+  private:
+
+    // Passes a pool's pages through to the real source and remembers which class they're for
+    class ClassPageSource : public PageSource
+    {
+      public:
+
+        void *AcquirePage(size_t Size, size_t Alignment) override;
+        void ReleasePage(void *Page, size_t Size, size_t Alignment) override;
+
+        SmallObjectAllocator *Owner_;  // where the page map is
+        PageSource *Source_;           // where the pages really come from
+        unsigned SizeClass_;           // the class of every page from here
+    };
+
+    // One page of a pool
+    struct PageRange
+    {
+      const char *End;     // one past the last byte of the page
+      unsigned SizeClass;  // the pool it belongs to
+    };
+
+    ObjectAllocator *Pools_[CLASS_COUNT];               // one pool per size class
+    ClassPageSource PageSources_[CLASS_COUNT];          // where each pool gets its pages
+    unsigned char ClassIndex_[MAX_SMALL_SIZE / 8 + 1];  // size class for every multiple of 8 bytes
+    std::atomic<size_t> LargeAllocations_;              // requests that went to the system, from any thread
+    bool SystemHeap_;                                   // the pools use the system heap, so there are no pages
+
+    std::map<const char*, PageRange> Pages_;            // every pool's pages by start address
+    mutable std::shared_mutex PagesLock_;               // written when a pool gets or gives back a page
+
+    int get_size_class(size_t Size, size_t Alignment) const;  // finds the pool for a request (-1 if none)
+    int find_page_class(const void *Object) const;            // finds the pool whose page holds an object (-1 if none)
+    static size_t get_class_alignment(unsigned SizeClass);     // alignment every object in a class gets
+
+    // Make private to prevent copy construction and assignment
+    SmallObjectAllocator(const SmallObjectAllocator &soa);
+    SmallObjectAllocator &operator=(const SmallObjectAllocator &soa);
+
+};
+
+// Lets whole pmr containers allocate out of a SmallObjectAllocator
+class SmallObjectResource : public std::pmr::memory_resource
+{
+  public:
+
+    // The allocator has to outlive the resource
+    explicit SmallObjectResource(SmallObjectAllocator &allocator) : allocator_(allocator) {}
+
+  private:
+
+    SmallObjectAllocator &allocator_;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+};
+
+#endif
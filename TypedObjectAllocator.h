@@ -0,0 +1,315 @@
+/*!*************************************************************************************************
+\file    TypedObjectAllocator.h
+\author  Seth Glaser
+\par     Email: seth.g\@digipen.edu
+\brief   This file holds a typed ObjectAllocator whose block layout is worked out at compile time.
+***************************************************************************************************/
+
+//--------------------------------------------------------------------------------------------------
+#ifndef TYPEDOBJECTALLOCATORH
+#define TYPEDOBJECTALLOCATORH
+//--------------------------------------------------------------------------------------------------
+
+#include "ObjectAllocator.h"  // OAException, OAStats, GenericObject, signature patterns
+#include <algorithm>          // std::upper_bound
+#include <cstring>            // memset
+#include <new>                // placement new, std::align_val_t
+#include <utility>            // std::forward
+#include <vector>             // std::vector
+
+// Compile time configuration, same meaning as the matching OAConfig members
+template <unsigned ObjectsPerPage = DEFAULT_OBJECTS_PER_PAGE,
+          unsigned MaxPages = DEFAULT_MAX_PAGES,
+          bool DebugOn = false,
+          unsigned PadBytes = 0,
+          unsigned Alignment = 0>
+struct OAStaticConfig
+{
+  static constexpr unsigned ObjectsPerPage_ = ObjectsPerPage;  // number of objects on each page
+  static constexpr unsigned MaxPages_ = MaxPages;              // maximum number of pages (0=unlimited)
+  static constexpr bool DebugOn_ = DebugOn;                    // signatures and checks, compiled out when false
+  static constexpr unsigned PadBytes_ = PadBytes;              // size of the left/right padding for each block
+  static constexpr unsigned Alignment_ = Alignment;            // address alignment of each block (0=alignof(T))
+
+  static_assert(ObjectsPerPage > 0, "A page needs at least one object");
+  static_assert((Alignment & (Alignment - 1)) == 0, "Alignment has to be a power of two");
+};
+
+// An ObjectAllocator for one type. Headers aren't supported, use ObjectAllocator for those.
+template <typename T, typename Config = OAStaticConfig<> >
+class TypedObjectAllocator
+{
+    // Used by the layout below, so they have to come first
+    static constexpr size_t max_of(size_t Left, size_t Right)
+    {
+      return Left < Right ? Right : Left;
+    }
+
+    static constexpr size_t power_of_two(size_t Value)
+    {
+      return (Value & (Value - 1)) == 0 ? Value : power_of_two(Value + 1);
+    }
+
+  public:
+
+    // Creates the allocator and its first page
+    // Throws an exception if the construction fails. (Memory allocation problem)
+    TypedObjectAllocator() : PageList_(nullptr), FreeList_(nullptr)
+    {
+      Statistics_.ObjectSize_ = ObjectSize;
+      Statistics_.PageSize_ = PageSize;
+
+      allocate_new_page();
+    }
+
+    // Releases every page, objects still in use are not destroyed (never throws)
+    ~TypedObjectAllocator()
+    {
+      while (PageList_ != nullptr)
+      {
+        GenericObject* temp = PageList_;
+        PageList_ = PageList_->Next;
+
+        operator delete(temp, std::align_val_t(PageAlignment));
+      }
+    }
+
+    // Takes a block off the free list and constructs a T in it
+    // Throws an exception if the object can't be allocated. (Memory allocation problem)
+    template <typename... Args>
+    T *create(Args&&... args)
+    {
+      void* block = allocate();
+
+      try
+      {
+        return new (block) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        deallocate(block);
+        throw;
+      }
+    }
+
+    // Destroys the T and puts its block back on the free list
+    // Throws an exception if the block can't be freed. (Invalid object, debug only)
+    void destroy(T *Object)
+    {
+      if (Object == nullptr)
+        return;
+
+      // Check it before running the destructor on something that isn't ours
+      if constexpr (Config::DebugOn_)
+        check_block(Object);
+
+      Object->~T();
+      deallocate(Object);
+    }
+
+    // Returns the statistics for the allocator
+    OAStats GetStats(void) const
+    {
+      return Statistics_;
+    }
+
+    // The block layout, all known at compile time
+    static constexpr size_t ObjectSize = sizeof(T) < sizeof(GenericObject) ? sizeof(GenericObject) : sizeof(T);
+    static constexpr size_t ObjectAlignment = max_of(max_of(alignof(T), alignof(GenericObject)), Config::Alignment_);
+    static constexpr size_t PageAlignment = power_of_two(ObjectAlignment);
+    static constexpr size_t BlockMapWords = Config::DebugOn_ ? (Config::ObjectsPerPage_ + 63) / 64 : 0;
+    static constexpr size_t PageHeaderSize = sizeof(GenericObject) + (BlockMapWords * sizeof(std::uint64_t));
+    static constexpr size_t LeftAlignSize = (ObjectAlignment - ((PageHeaderSize + Config::PadBytes_) % ObjectAlignment))
+                                            % ObjectAlignment;
+    static constexpr size_t BlockSize = ObjectSize + (Config::PadBytes_ * 2);
+    static constexpr size_t InterAlignSize = (ObjectAlignment - (BlockSize % ObjectAlignment)) % ObjectAlignment;
+    static constexpr size_t Stride = BlockSize + InterAlignSize;
+    static constexpr size_t FirstObject = PageHeaderSize + LeftAlignSize + Config::PadBytes_;
+    static constexpr size_t PageSize = FirstObject + (Stride * (Config::ObjectsPerPage_ - 1)) +
+                                       ObjectSize + Config::PadBytes_;
+
+  private:
+
+    GenericObject *PageList_;        // the beginning of the list of pages
+    GenericObject *FreeList_;        // the beginning of the list of objects
+    OAStats Statistics_;             // the stats for the allocator
+    std::vector<char*> PageIndex_;   // every page, sorted by address (debug only)
+
+    // Takes the first block off the free list
+    void *allocate(void)
+    {
+      if (FreeList_ == nullptr)
+        allocate_new_page();
+
+      GenericObject* block = FreeList_;
+      FreeList_ = block->Next;
+
+      // Adjust stats
+      ++Statistics_.Allocations_;
+      ++Statistics_.ObjectsInUse_;
+      --Statistics_.FreeObjects_;
+      if (Statistics_.ObjectsInUse_ > Statistics_.MostObjects_)
+        Statistics_.MostObjects_ = Statistics_.ObjectsInUse_;
+
+      // Add the correct signature and mark the block as taken
+      if constexpr (Config::DebugOn_)
+      {
+        memset(block, ObjectAllocator::ALLOCATED_PATTERN, ObjectSize);
+        set_block_state(block, true);
+      }
+
+      return block;
+    }
+
+    // Puts a block back on the front of the free list
+    void deallocate(void *Block)
+    {
+      // Add the correct signature and mark the block as free
+      if constexpr (Config::DebugOn_)
+      {
+        memset(Block, ObjectAllocator::FREED_PATTERN, ObjectSize);
+        set_block_state(Block, false);
+      }
+
+      GenericObject* block = reinterpret_cast<GenericObject*>(Block);
+      block->Next = FreeList_;
+      FreeList_ = block;
+
+      // Adjust stats
+      --Statistics_.ObjectsInUse_;
+      ++Statistics_.FreeObjects_;
+      ++Statistics_.Deallocations_;
+    }
+
+    // Allocates another page and puts all of its blocks on the free list
+    void allocate_new_page(void)
+    {
+      // Check to see if you need to throw or not
+      if (Config::MaxPages_ != 0 && Statistics_.PagesInUse_ == Config::MaxPages_)
+        throw OAException(OAException::E_NO_PAGES, "Max pages have been made!");
+
+      char* page = nullptr;
+
+      try
+      {
+        page = static_cast<char*>(operator new(PageSize, std::align_val_t(PageAlignment)));
+      }
+      catch (std::bad_alloc&)
+      {
+        throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+      }
+
+      // Keep the index sorted so lookups can binary search it, before the page is used anywhere else
+      if constexpr (Config::DebugOn_)
+      {
+        try
+        {
+          PageIndex_.insert(std::upper_bound(PageIndex_.begin(), PageIndex_.end(), page), page);
+        }
+        catch (std::bad_alloc&)
+        {
+          operator delete(page, std::align_val_t(PageAlignment));
+          throw OAException(OAException::E_NO_MEMORY, "No physical memory left!");
+        }
+      }
+
+      // Set the correct pattern bytes
+      if constexpr (Config::DebugOn_)
+      {
+        memset(page, ObjectAllocator::UNALLOCATED_PATTERN, PageSize);
+        memset(page + sizeof(GenericObject), 0, BlockMapWords * sizeof(std::uint64_t));
+        memset(page + PageHeaderSize, ObjectAllocator::ALIGN_PATTERN, LeftAlignSize);
+
+        for (unsigned i = 0; i < Config::ObjectsPerPage_; ++i)
+        {
+          char* object = page + FirstObject + (Stride * i);
+
+          memset(object - Config::PadBytes_, ObjectAllocator::PAD_PATTERN, Config::PadBytes_);
+          memset(object + ObjectSize, ObjectAllocator::PAD_PATTERN, Config::PadBytes_);
+          if (i + 1 < Config::ObjectsPerPage_)
+            memset(object + ObjectSize + Config::PadBytes_, ObjectAllocator::ALIGN_PATTERN, InterAlignSize);
+        }
+      }
+
+      // Set the page to look at the old head and become the new head
+      reinterpret_cast<GenericObject*>(page)->Next = PageList_;
+      PageList_ = reinterpret_cast<GenericObject*>(page);
+
+      // Thread the blocks back to front, so the first block comes out first
+      for (unsigned i = Config::ObjectsPerPage_; i > 0; --i)
+      {
+        GenericObject* block = reinterpret_cast<GenericObject*>(page + FirstObject + (Stride * (i - 1)));
+        block->Next = FreeList_;
+        FreeList_ = block;
+      }
+
+      // Adjust the statistics
+      ++Statistics_.PagesInUse_;
+      Statistics_.FreeObjects_ += Config::ObjectsPerPage_;
+    }
+
+    // Finds the page a block is on (debug only)
+    char *find_page(const void *Block) const
+    {
+      const char* address = reinterpret_cast<const char*>(Block);
+
+      // The first page that starts after the address
+      typename std::vector<char*>::const_iterator next = std::upper_bound(PageIndex_.begin(), PageIndex_.end(), address);
+
+      // The address is before every page
+      if (next == PageIndex_.begin())
+        return nullptr;
+
+      // The only page that could hold it is the one before that
+      char* page = *(next - 1);
+      if (address > page && address < page + PageSize)
+        return page;
+
+      return nullptr;
+    }
+
+    // Marks a block as in use or free in its page's block map (debug only)
+    void set_block_state(void *Block, bool InUse)
+    {
+      char* page = find_page(Block);
+      size_t index = (reinterpret_cast<char*>(Block) - (page + FirstObject)) / Stride;
+      std::uint64_t* map = reinterpret_cast<std::uint64_t*>(page + sizeof(GenericObject));
+
+      if (InUse)
+        map[index / 64] |= std::uint64_t(1) << (index % 64);
+      else
+        map[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    }
+
+    // Checks the bounds, double free and padding of a block being destroyed (debug only)
+    void check_block(const void *Block) const
+    {
+      const char* block = reinterpret_cast<const char*>(Block);
+      char* page = find_page(Block);
+
+      // It has to land exactly on the start of a block
+      if (page == nullptr || block < page + FirstObject || (block - (page + FirstObject)) % Stride)
+        throw OAException(OAException::E_BAD_BOUNDARY, "Object is not on a page correctly!");
+
+      // The block map says whether the client still owns this block
+      size_t index = (block - (page + FirstObject)) / Stride;
+      const std::uint64_t* map = reinterpret_cast<const std::uint64_t*>(page + sizeof(GenericObject));
+      if (!((map[index / 64] >> (index % 64)) & 1))
+        throw OAException(OAException::E_MULTIPLE_FREE, "Object has already been freed!");
+
+      // Check if the pad bytes have been touched
+      for (unsigned i = 0; i < Config::PadBytes_; ++i)
+      {
+        if (static_cast<unsigned char>(block[-1 - static_cast<int>(i)]) != ObjectAllocator::PAD_PATTERN ||
+            static_cast<unsigned char>(block[ObjectSize + i]) != ObjectAllocator::PAD_PATTERN)
+          throw OAException(OAException::E_CORRUPTED_BLOCK, "The boundaries of this object were corrupted!");
+      }
+    }
+
+    // Make private to prevent copy construction and assignment
+    TypedObjectAllocator(const TypedObjectAllocator &oa);
+    TypedObjectAllocator &operator=(const TypedObjectAllocator &oa);
+
+};
+
+#endif